@@ -27,6 +27,9 @@
  - NeighborhoodExplorer: handles all the features concerning neighborhood exploration in an @e iterator
  fashion.
  
+ - StaticNeighborhoodExplorer: a NeighborhoodExplorer whose delta cost components are given as template
+ parameters and evaluated without virtual dispatch.
+ 
  - DeltaCostComponent: is responsible for computing the difference of the cost function due to the application
  of a @ref Move on a given @ref State.
  
@@ -41,5 +44,6 @@
 #include "helpers/kicker.hh"
 #include "helpers/neighborhoodexplorer.hh"
 #include "helpers/outputmanager.hh"
+#include "helpers/staticneighborhoodexplorer.hh"
 #include "helpers/statemanager.hh"
 
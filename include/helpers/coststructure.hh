@@ -1,5 +1,9 @@
 #pragma once
 
+#include <array>
+#include <vector>
+#include <stdexcept>
+
 #include "utils/types.hh"
 
 namespace EasyLocal
@@ -10,17 +14,72 @@ namespace Core
 
 // FIXME: it is likely that the semantics of equality and inequality in case of hybrid comparison (i.e., CostStructure against scalar) is not meaningful. Probably it can be safely removed.
 
-template <typename T>
+/** A fixed-capacity replacement for @c std::vector which stores its elements inline. It is used to hold the components of a @ref FixedCostStructure, so that cost structures can be created, copied and combined without touching the heap.
+     @tparam T the type of the elements
+     @tparam N the maximum number of elements
+     */
+template <typename T, size_t N>
+class FixedComponents
+{
+public:
+  typedef T value_type;
+  typedef T *iterator;
+  typedef const T *const_iterator;
+
+  explicit FixedComponents(size_t n = 0, const T &value = T()) : n(0)
+  {
+    resize(n, value);
+  }
+
+  /** Conversion from a @c std::vector, for compatibility with code building the components dynamically. */
+  FixedComponents(const std::vector<T> &v) : n(0)
+  {
+    resize(v.size());
+    for (size_t i = 0; i < n; i++)
+      values[i] = v[i];
+  }
+
+  size_t size() const { return n; }
+
+  bool empty() const { return n == 0; }
+
+  static constexpr size_t capacity() { return N; }
+
+  /** Resizes the container, throws a @c std::length_error if the capacity is exceeded. */
+  void resize(size_t m, const T &value = T())
+  {
+    if (m > N)
+      throw std::length_error("The number of cost components exceeds the capacity of the fixed cost structure");
+    for (size_t i = n; i < m; i++)
+      values[i] = value;
+    n = m;
+  }
+
+  T &operator[](size_t i) { return values[i]; }
+  const T &operator[](size_t i) const { return values[i]; }
+
+  iterator begin() { return values.data(); }
+  iterator end() { return values.data() + n; }
+  const_iterator begin() const { return values.data(); }
+  const_iterator end() const { return values.data() + n; }
+
+protected:
+  std::array<T, N> values;
+  size_t n;
+};
+
+template <typename T, class Components = std::vector<T>>
 struct DefaultCostStructure
 {
   typedef T CFtype;
+  typedef Components ComponentsType;
 
   DefaultCostStructure() : total(0), violations(0), objective(0), all_components(0), weighted(0.0), is_weighted(false) {}
-  DefaultCostStructure(CFtype total, CFtype violations, CFtype objective, const std::vector<CFtype> &all_components) : total(total), violations(violations), objective(objective), all_components(all_components), weighted(total), is_weighted(false) {}
-  DefaultCostStructure(CFtype total, double weighted, CFtype violations, CFtype objective, const std::vector<CFtype> &all_components) : total(total), violations(violations), objective(objective), all_components(all_components), weighted(weighted), is_weighted(true) {}
+  DefaultCostStructure(CFtype total, CFtype violations, CFtype objective, const Components &all_components) : total(total), violations(violations), objective(objective), all_components(all_components), weighted(total), is_weighted(false) {}
+  DefaultCostStructure(CFtype total, double weighted, CFtype violations, CFtype objective, const Components &all_components) : total(total), violations(violations), objective(objective), all_components(all_components), weighted(weighted), is_weighted(true) {}
 
   CFtype total, violations, objective;
-  std::vector<CFtype> all_components;
+  Components all_components;
   double weighted;
 
   bool is_weighted;
@@ -60,198 +119,209 @@ struct DefaultCostStructure
   }
 };
 
-template <typename CFtype>
-DefaultCostStructure<CFtype> operator+(const DefaultCostStructure<CFtype> &cs1, const DefaultCostStructure<CFtype> &cs2)
+/** States whether cost structures are compared by a single scalar value (the weighted or the total cost) */
+template <class CostStructure>
+struct IsScalarCostStructure : std::false_type
+{
+};
+
+template <typename CFtype, class Components>
+struct IsScalarCostStructure<DefaultCostStructure<CFtype, Components>> : std::true_type
+{
+};
+
+template <typename CFtype, class Components>
+DefaultCostStructure<CFtype, Components> operator+(const DefaultCostStructure<CFtype, Components> &cs1, const DefaultCostStructure<CFtype, Components> &cs2)
 {
-  DefaultCostStructure<CFtype> res = cs1;
+  DefaultCostStructure<CFtype, Components> res = cs1;
   res += cs2;
   return res;
 }
 
-template <typename CFtype>
-DefaultCostStructure<CFtype> operator-(const DefaultCostStructure<CFtype> &cs1, const DefaultCostStructure<CFtype> &cs2)
+template <typename CFtype, class Components>
+DefaultCostStructure<CFtype, Components> operator-(const DefaultCostStructure<CFtype, Components> &cs1, const DefaultCostStructure<CFtype, Components> &cs2)
 {
-  DefaultCostStructure<CFtype> res = cs1;
+  DefaultCostStructure<CFtype, Components> res = cs1;
   res -= cs2;
   return res;
 }
 
-template <class CFtype>
-bool operator<(const DefaultCostStructure<CFtype> &cs1, const DefaultCostStructure<CFtype> &cs2)
+template <class CFtype, class Components>
+bool operator<(const DefaultCostStructure<CFtype, Components> &cs1, const DefaultCostStructure<CFtype, Components> &cs2)
 {
   if (cs1.is_weighted && cs2.is_weighted)
     return LessThan(cs1.weighted, cs2.weighted);
   return LessThan(cs1.total, cs2.total);
 }
 
-template <class CFtype, typename OtherType>
-bool operator<(OtherType c1, const DefaultCostStructure<CFtype> &cs2)
+template <class CFtype, class Components, typename OtherType>
+bool operator<(OtherType c1, const DefaultCostStructure<CFtype, Components> &cs2)
 {
   if (cs2.is_weighted)
     return LessThan((double)c1, cs2.weighted);
   return LessThan(static_cast<CFtype>(c1), cs2.total);
 }
 
-template <class CFtype>
-bool operator<(double c1, const DefaultCostStructure<CFtype> &cs2)
+template <class CFtype, class Components>
+bool operator<(double c1, const DefaultCostStructure<CFtype, Components> &cs2)
 {
   if (cs2.is_weighted)
     return LessThan(c1, cs2.weighted);
   return LessThan(c1, static_cast<double>(cs2.total));
 }
 
-template <class CFtype, typename OtherType>
-bool operator<(const DefaultCostStructure<CFtype> &cs1, OtherType c2)
+template <class CFtype, class Components, typename OtherType>
+bool operator<(const DefaultCostStructure<CFtype, Components> &cs1, OtherType c2)
 {
   if (cs1.is_weighted)
     return LessThan(cs1.weighted, (double)c2);
   return LessThan(cs1.total, static_cast<CFtype>(c2));
 }
 
-template <class CFtype>
-bool operator<(const DefaultCostStructure<CFtype> &cs1, double c2)
+template <class CFtype, class Components>
+bool operator<(const DefaultCostStructure<CFtype, Components> &cs1, double c2)
 {
   if (cs1.is_weighted)
     return LessThan(cs1.weighted, c2);
   return LessThan(static_cast<double>(cs1.total), c2);
 }
 
-template <class CFtype>
-bool operator<=(const DefaultCostStructure<CFtype> &cs1, const DefaultCostStructure<CFtype> &cs2)
+template <class CFtype, class Components>
+bool operator<=(const DefaultCostStructure<CFtype, Components> &cs1, const DefaultCostStructure<CFtype, Components> &cs2)
 {
   if (cs1.is_weighted && cs2.is_weighted)
     return LessThanOrEqualTo(cs1.weighted, cs2.weighted);
   return LessThanOrEqualTo(cs1.total, cs2.total);
 }
 
-template <class CFtype, typename OtherType>
-bool operator<=(OtherType c1, const DefaultCostStructure<CFtype> &cs2)
+template <class CFtype, class Components, typename OtherType>
+bool operator<=(OtherType c1, const DefaultCostStructure<CFtype, Components> &cs2)
 {
   if (cs2.is_weighted)
     return LessThanOrEqualTo((double)c1, cs2.weighted);
   return LessThanOrEqualTo(static_cast<CFtype>(c1), cs2.total);
 }
 
-template <class CFtype>
-bool operator<=(double c1, const DefaultCostStructure<CFtype> &cs2)
+template <class CFtype, class Components>
+bool operator<=(double c1, const DefaultCostStructure<CFtype, Components> &cs2)
 {
   if (cs2.is_weighted)
     return LessThanOrEqualTo(c1, cs2.weighted);
   return LessThanOrEqualTo(c1, static_cast<double>(cs2.total));
 }
 
-template <class CFtype, typename OtherType>
-bool operator<=(const DefaultCostStructure<CFtype> &cs1, OtherType c2)
+template <class CFtype, class Components, typename OtherType>
+bool operator<=(const DefaultCostStructure<CFtype, Components> &cs1, OtherType c2)
 {
   if (cs1.is_weighted)
     return LessThanOrEqualTo(cs1.weighted, (double)c2);
   return LessThanOrEqualTo(cs1.total, static_cast<CFtype>(c2));
 }
 
-template <class CFtype>
-bool operator<=(const DefaultCostStructure<CFtype> &cs1, double c2)
+template <class CFtype, class Components>
+bool operator<=(const DefaultCostStructure<CFtype, Components> &cs1, double c2)
 {
   if (cs1.is_weighted)
     return LessThanOrEqualTo(cs1.weighted, c2);
   return LessThanOrEqualTo(static_cast<double>(cs1.total), c2);
 }
 
-template <class CFtype>
-bool operator==(const DefaultCostStructure<CFtype> &cs1, const DefaultCostStructure<CFtype> &cs2)
+template <class CFtype, class Components>
+bool operator==(const DefaultCostStructure<CFtype, Components> &cs1, const DefaultCostStructure<CFtype, Components> &cs2)
 {
   if (cs1.is_weighted && cs2.is_weighted)
     return EqualTo(cs1.weighted, cs2.weighted);
   return EqualTo(cs1.total, cs2.total);
 }
 
-template <class CFtype, typename OtherType>
-bool operator==(OtherType c1, const DefaultCostStructure<CFtype> &cs2)
+template <class CFtype, class Components, typename OtherType>
+bool operator==(OtherType c1, const DefaultCostStructure<CFtype, Components> &cs2)
 {
   if (cs2.is_weighted)
     return EqualTo((double)c1, cs2.weighted);
   return EqualTo(static_cast<CFtype>(c1), cs2.total);
 }
 
-template <class CFtype>
-bool operator==(double c1, const DefaultCostStructure<CFtype> &cs2)
+template <class CFtype, class Components>
+bool operator==(double c1, const DefaultCostStructure<CFtype, Components> &cs2)
 {
   if (cs2.is_weighted)
     return EqualTo(c1, cs2.weighted);
   return EqualTo(c1, static_cast<double>(cs2.total));
 }
 
-template <class CFtype, typename OtherType>
-bool operator==(const DefaultCostStructure<CFtype> &cs1, OtherType c2)
+template <class CFtype, class Components, typename OtherType>
+bool operator==(const DefaultCostStructure<CFtype, Components> &cs1, OtherType c2)
 {
   if (cs1.is_weighted)
     return EqualTo(cs1.weighted, (double)c2);
   return EqualTo(cs1.total, static_cast<CFtype>(c2));
 }
 
-template <class CFtype, typename OtherType>
-bool operator==(const DefaultCostStructure<CFtype> &cs1, double c2)
+template <class CFtype, class Components, typename OtherType>
+bool operator==(const DefaultCostStructure<CFtype, Components> &cs1, double c2)
 {
   if (cs1.is_weighted)
     return EqualTo(cs1.weighted, c2);
   return EqualTo(static_cast<double>(cs1.total), c2);
 }
 
-template <class CFtype>
-bool operator>=(const DefaultCostStructure<CFtype> &cs1, const DefaultCostStructure<CFtype> &cs2)
+template <class CFtype, class Components>
+bool operator>=(const DefaultCostStructure<CFtype, Components> &cs1, const DefaultCostStructure<CFtype, Components> &cs2)
 {
   return !(cs1 < cs2);
 }
 
-template <class CFtype, class OtherType>
-bool operator>=(OtherType c1, const DefaultCostStructure<CFtype> &cs2)
+template <class CFtype, class Components, class OtherType>
+bool operator>=(OtherType c1, const DefaultCostStructure<CFtype, Components> &cs2)
 {
   return !(c1 < cs2);
 }
 
-template <class CFtype, typename OtherType>
-bool operator>=(const DefaultCostStructure<CFtype> &cs1, OtherType c2)
+template <class CFtype, class Components, typename OtherType>
+bool operator>=(const DefaultCostStructure<CFtype, Components> &cs1, OtherType c2)
 {
   return !(cs1 < c2);
 }
 
-template <class CFtype>
-bool operator>(const DefaultCostStructure<CFtype> &cs1, const DefaultCostStructure<CFtype> &cs2)
+template <class CFtype, class Components>
+bool operator>(const DefaultCostStructure<CFtype, Components> &cs1, const DefaultCostStructure<CFtype, Components> &cs2)
 {
   return !(cs1 <= cs2);
 }
 
-template <class CFtype, typename OtherType>
-bool operator>(OtherType c1, const DefaultCostStructure<CFtype> &cs2)
+template <class CFtype, class Components, typename OtherType>
+bool operator>(OtherType c1, const DefaultCostStructure<CFtype, Components> &cs2)
 {
   return !(c1 <= cs2);
 }
 
-template <class CFtype, typename OtherType>
-bool operator>(const DefaultCostStructure<CFtype> &cs1, OtherType c2)
+template <class CFtype, class Components, typename OtherType>
+bool operator>(const DefaultCostStructure<CFtype, Components> &cs1, OtherType c2)
 {
   return !(cs1 <= c2);
 }
 
-template <class CFtype>
-bool operator!=(const DefaultCostStructure<CFtype> &cs1, const DefaultCostStructure<CFtype> &cs2)
+template <class CFtype, class Components>
+bool operator!=(const DefaultCostStructure<CFtype, Components> &cs1, const DefaultCostStructure<CFtype, Components> &cs2)
 {
   return !(cs1 == cs2);
 }
 
-template <class CFtype, typename OtherType>
-bool operator!=(OtherType c1, const DefaultCostStructure<CFtype> &cs2)
+template <class CFtype, class Components, typename OtherType>
+bool operator!=(OtherType c1, const DefaultCostStructure<CFtype, Components> &cs2)
 {
   return !(c1 == cs2);
 }
 
-template <class CFtype, typename OtherType>
-bool operator!=(const DefaultCostStructure<CFtype> &cs1, OtherType c2)
+template <class CFtype, class Components, typename OtherType>
+bool operator!=(const DefaultCostStructure<CFtype, Components> &cs1, OtherType c2)
 {
   return !(cs1 == c2);
 }
 
-template <typename CFtype>
-std::ostream &operator<<(std::ostream &os, const DefaultCostStructure<CFtype> &cc)
+template <typename CFtype, class Components>
+std::ostream &operator<<(std::ostream &os, const DefaultCostStructure<CFtype, Components> &cc)
 {
   os << cc.total << " (viol: " << cc.violations << ", obj: " << cc.objective << ", comps: {";
   for (size_t i = 0; i < cc.all_components.size(); i++)
@@ -265,10 +335,18 @@ std::ostream &operator<<(std::ostream &os, const DefaultCostStructure<CFtype> &c
   return os;
 }
 
+/** A cost structure with the same semantics of @ref DefaultCostStructure, whose (at most N) components are stored inline. Since it never allocates memory, it is meant to be used in place of @ref DefaultCostStructure whenever the number of cost components is known at compile time, so that move evaluation does not stress the allocator.
+     @tparam T the type of the cost function
+     @tparam N the maximum number of cost components
+     */
+template <typename T, size_t N>
+using FixedCostStructure = DefaultCostStructure<T, FixedComponents<T, N>>;
+
 template <typename T>
 struct HierarchicalCostStructure
 {
   typedef T CFtype;
+  typedef std::vector<T> ComponentsType;
 
   HierarchicalCostStructure() : total(0), violations(0), objective(0), all_components(0), weighted(0.0), is_weighted(false) {}
   HierarchicalCostStructure(CFtype total, CFtype violations, CFtype objective, const std::vector<CFtype> &all_components) : total(total), violations(violations), objective(objective), all_components(all_components), weighted(total), is_weighted(false) {}
@@ -41,6 +41,22 @@ public:
   /** Returns whether the delta function is implemented, or the complete cost component is used. */
   virtual bool IsDeltaImplemented() const { return true; }
 
+  /** Returns whether a lower bound of the variation of the cost is available (see @ref DeltaCostLowerBound). */
+  virtual bool IsDeltaBounded() const { return false; }
+
+  /** Returns a lower bound of the (unweighted) variation of the cost induced by the move, i.e., of the value returned by @ref ComputeDeltaCost. It is used to stop the evaluation of a move as soon as it is proved to be rejected, therefore it should be much cheaper to compute than the variation itself.
+       @note Can be implemented in the application (MayRedef), together with @ref IsDeltaBounded
+       @param st state to evaluate
+       @param mv move to evaluate
+       */
+  virtual CFtype DeltaCostLowerBound(const State &st, const Move &mv) const
+  {
+    throw std::logic_error("DeltaCostLowerBound is not implemented in " + name);
+  }
+
+  /** Returns an estimate of the (relative) effort required to compute the variation of the cost, which is used to sort the components when they are evaluated cheapest first. */
+  virtual double EvaluationCost() const { return 1.0; }
+
   /** A symbolic name of the DeltaCostComponent. */
   const std::string name;
 
@@ -113,9 +129,7 @@ protected:
   /** @copydoc DeltaCostComponent::ComputeDeltaCost() */
   virtual CFtype ComputeDeltaCost(const State &st, const Move &mv) const
   {
-    State new_st = st;
-    ne.MakeMove(new_st, mv);
-    return this->cc.ComputeCost(new_st) - this->cc.ComputeCost(st);
+    return ne.CostComponentDifference(this->cc, st, mv);
   }
   const NeighborhoodExplorer<Input, State, Move, CostStructure> &ne;
 };
@@ -430,6 +430,7 @@ public:
   virtual ~Kicker() {}
 
   /** Generates the first improving kick.
+       @remarks the generation stops once the @ref CancellationToken of the calling thread is cancelled
        @param st current @ref State
        @param kick the sequence of @ref Move to generate
        @param length length of the kick
@@ -438,9 +439,10 @@ public:
        */
   virtual std::pair<Kick<State, Move, CostStructure>, CostStructure> SelectFirst(size_t length, const State &st) const
   {
-    for (FullKickerIterator<Input, State, Move, CostStructure> it = begin(length, st); it != end(length, st); ++it)
+    const CancellationToken token = CancellationToken::Current();
+    for (FullKickerIterator<Input, State, Move, CostStructure> it = begin(length, st); it != end(length, st) && !token.IsCancelled(); ++it)
     {
-      CostStructure cost(0, 0, 0, std::vector<CFtype>(sm.CostComponents(), 0));
+      CostStructure cost(0, 0, 0, typename CostStructure::ComponentsType(sm.CostComponents(), 0));
       for (int i = 0; i < it->size(); i++)
       {
         if (!(*it)[i].first.is_valid)
@@ -453,10 +455,11 @@ public:
       if (cost < 0)
         return std::make_pair(*it, cost);
     }
-    return std::make_pair(Kick<State, Move, CostStructure>::empty, CostStructure(std::numeric_limits<CFtype>::infinity(), std::numeric_limits<CFtype>::infinity(), std::numeric_limits<CFtype>::infinity(), std::vector<CFtype>(sm.CostComponents(), std::numeric_limits<CFtype>::infinity())));
+    return std::make_pair(Kick<State, Move, CostStructure>::empty, CostStructure(std::numeric_limits<CFtype>::infinity(), std::numeric_limits<CFtype>::infinity(), std::numeric_limits<CFtype>::infinity(), typename CostStructure::ComponentsType(sm.CostComponents(), std::numeric_limits<CFtype>::infinity())));
   }
 
   /** Generates the best kick.
+       @remarks the generation stops once the @ref CancellationToken of the calling thread is cancelled, and the best kick evaluated so far is returned
        @param st current @ref State
        @param kick the sequence of @ref Move to generate
        @param length length of the kick
@@ -468,9 +471,10 @@ public:
     Kick<State, Move, CostStructure> best_kick;
     CostStructure best_cost;
     unsigned int number_of_bests = 0;
-    for (FullKickerIterator<Input, State, Move, CostStructure> it = begin(length, st); it != end(length, st); ++it)
+    const CancellationToken token = CancellationToken::Current();
+    for (FullKickerIterator<Input, State, Move, CostStructure> it = begin(length, st); it != end(length, st) && (number_of_bests == 0 || !token.IsCancelled()); ++it)
     {
-      CostStructure cost(0, 0, 0, std::vector<CFtype>(sm.CostComponents(), 0));
+      CostStructure cost(0, 0, 0, typename CostStructure::ComponentsType(sm.CostComponents(), 0));
       for (int i = 0; i < it->size(); i++)
       {
         if (!(*it)[i].first.is_valid)
@@ -505,7 +509,7 @@ public:
   virtual std::pair<Kick<State, Move, CostStructure>, CostStructure> SelectRandom(size_t length, const State &st) const
   {
     SampleKickerIterator<Input, State, Move, CostStructure> random_it = sample_begin(length, st, 1);
-    CostStructure cost(0, 0, 0, std::vector<CFtype>(sm.CostComponents(), 0));
+    CostStructure cost(0, 0, 0, typename CostStructure::ComponentsType(sm.CostComponents(), 0));
     for (int i = 0; i < random_it->size(); i++)
     {
       if (!(*random_it)[i].first.is_valid)
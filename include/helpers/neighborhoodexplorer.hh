@@ -1,15 +1,23 @@
 #pragma once
 
+#include <cassert>
 #include <typeinfo>
 #include <iostream>
 #include <stdexcept>
 #include <memory>
 #include <iterator>
 #include <functional>
+#include <algorithm>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 #include "helpers/deltacostcomponent.hh"
 #include "helpers/statemanager.hh"
 #include "utils/random.hh"
+#include "utils/cancellation.hh"
 
 namespace EasyLocal
 {
@@ -51,8 +59,26 @@ std::ostream &operator<<(std::ostream &os, const EvaluatedMove<Move, CostStructu
 template <class Move, class CostStructure>
 EvaluatedMove<Move, CostStructure> EvaluatedMove<Move, CostStructure>::empty = EvaluatedMove<Move, CostStructure>();
 
+/** A buffer of contiguous moves and of their costs, used by the neighborhood explorers for batch evaluation. The buffer only grows, so that it can be reused across explorations without further allocations. */
+template <class Move, class CostStructure>
+struct MoveBatch
+{
+  void Reserve(size_t n)
+  {
+    if (moves.size() < n)
+    {
+      moves.resize(n);
+      costs.resize(n);
+    }
+  }
+
+  std::vector<Move> moves;
+  std::vector<CostStructure> costs;
+};
+
 /** The Neighborhood Explorer is responsible for the strategy exploited in the exploration of the neighborhood, and for computing the variations of the cost function due to a specific
      @ref Move.
+     The exploration methods poll the @ref CancellationToken of the calling thread after each batch of moves, and once it is cancelled they return the move selected among the ones evaluated so far.
      @ingroup Helpers
      */
 template <class Input, class State, class Move, class CostStructure = DefaultCostStructure<int>>
@@ -67,6 +93,19 @@ public:
 
   typedef typename std::function<bool(const Move &mv, const CostStructure &move_cost)> MoveAcceptor;
 
+  /** A function returning, before the evaluation of each move, a threshold such that the moves whose cost (weighted, if weights are given) exceeds it are surely rejected by the acceptance criterion */
+  typedef typename std::function<double()> MoveThreshold;
+
+  /** An acceptance criterion which receives, along with the move and its cost, the threshold drawn for it by a @ref MoveThreshold (so that the draws of concurrent explorations do not share any state) */
+  typedef typename std::function<bool(const Move &mv, const CostStructure &move_cost, double threshold)> ThresholdMoveAcceptor;
+
+  /** The order in which the delta cost components are evaluated */
+  enum class ComponentOrder
+  {
+    HardFirst,    /**< hard components first, then soft ones, in the order they have been added */
+    CheapestFirst /**< in increasing order of @ref DeltaCostComponent::EvaluationCost */
+  };
+
   /* Copies all the delta cost components from another neighborhood explorer of the same class
        @param ne the neighborhood explorer from which the data has to be copied
        */
@@ -77,6 +116,7 @@ public:
     this->dcc_adapters = ne.dcc_adapters;
     this->unimplemented_hard_components = ne.unimplemented_hard_components;
     this->unimplemented_soft_components = ne.unimplemented_soft_components;
+    BuildComponentSlots();
   }
 
   /** Checks if a move in the neighborhood is legal.
@@ -118,6 +158,64 @@ public:
        */
   virtual void MakeMove(State &st, const Move &mv) const = 0;
 
+  /** Reverts the application of a move, i.e., after @c MakeMove(st, mv) and @c UndoMove(st, mv) the state @c st must be equal to the original one. When it is available (see @ref IsUndoImplemented), the cost components without a delta implementation are evaluated by applying and reverting moves on a scratch copy of the state, which is made once per batch of moves, instead of copying the state for each move.
+       @note Can be implemented in the application (MayRedef), together with @ref IsUndoImplemented
+       @param st the state to modify
+       @param mv the move to be reverted
+       */
+  virtual void UndoMove(State &st, const Move &mv) const
+  {
+    throw std::logic_error("UndoMove is not implemented in " + name);
+  }
+
+  /** Returns whether @ref UndoMove is implemented. */
+  virtual bool IsUndoImplemented() const
+  {
+    return false;
+  }
+
+  /** Returns the change in the fingerprint of a state due to the application of a move, to be combined by xor with the fingerprint of the state. Fingerprints identify the states visited by a run (e.g., for detecting cycles) without hashing the whole state at each step: they are usually built by Zobrist hashing, i.e., as the xor of random keys drawn for each attribute of the state (e.g., each pair item/value), so that the change is the xor of the keys of the attributes removed and added by the move.
+       @note Can be implemented in the application (MayRedef), together with @ref IsFingerprintImplemented
+       @param st the state, before the application of the move
+       @param mv the move
+       */
+  virtual size_t FingerprintDelta(const State &st, const Move &mv) const
+  {
+    throw std::logic_error("FingerprintDelta is not implemented in " + name);
+  }
+
+  /** Returns whether @ref FingerprintDelta is implemented. */
+  virtual bool IsFingerprintImplemented() const
+  {
+    return false;
+  }
+
+  /** Returns the number of moves in the neighborhood of a state, which are indexed from 0 to @c NeighborhoodSize(st) - 1 by @ref MoveAt. When it is available (see @ref IsIndexImplemented), the neighborhood can be partitioned in ranges of indices which are generated and evaluated independently, e.g., by a parallel explorer.
+       @note Can be implemented in the application (MayRedef), together with @ref MoveAt and @ref IsIndexImplemented. The rejectionless mode of @ref AbstractSimulatedAnnealing assumes that @ref RandomMove draws each of the indexed moves with the same probability, i.e., 1 / @c NeighborhoodSize(st) (which is not the case, e.g., of a swap generator drawing i and then j > i).
+       @param st the state
+       */
+  virtual size_t NeighborhoodSize(const State &st) const
+  {
+    throw std::logic_error("NeighborhoodSize is not implemented in " + name);
+  }
+
+  /** Generates the move at a given position in the neighborhood of a state (see @ref NeighborhoodSize).
+       @note Can be implemented in the application (MayRedef), together with @ref NeighborhoodSize and @ref IsIndexImplemented. Each move of the neighborhood must be generated at exactly one position.
+       @param st the state
+       @param index the position of the move, in the range [0, @c NeighborhoodSize(st))
+       @param mv the generated move
+       */
+  virtual void MoveAt(const State &st, size_t index, Move &mv) const
+  {
+    throw std::logic_error("MoveAt is not implemented in " + name);
+  }
+
+  /** Returns whether @ref NeighborhoodSize and @ref MoveAt are implemented. */
+  virtual bool IsIndexImplemented() const
+  {
+    return false;
+  }
+
   /** Computes the differences in the cost function obtained by applying the move @c mv to the state @c st and returns the unaggregated value as a vector of components.
        @param st the state to modify
        @param mv the move to be applied
@@ -125,6 +223,50 @@ public:
        */
   virtual CostStructure DeltaCostFunctionComponents(const State &st, const Move &mv, const std::vector<double> &weights = std::vector<double>(0)) const;
 
+  /** Computes the differences in the cost function for a batch of moves applied to the same state @c st. The exhaustive explorations and @ref RandomBest evaluate moves in batches through this method, therefore it can be redefined in the application to share per-state precomputation across the whole batch. @ref RandomFirst evaluates the moves one at a time instead (through this method, or through @ref BoundedDeltaCostFunctionComponents when a threshold is given), in order not to draw moves past the accepted one. By default it calls @ref DeltaCostFunctionComponents on each move.
+       @note Can be implemented in the application (MayRedef)
+       @param st the start state
+       @param moves a pointer to the first of @c n contiguous moves
+       @param n the number of moves in the batch
+       @param costs a caller-owned buffer of at least @c n elements, where the cost of each move is written
+       */
+  virtual void BatchDeltaCostFunctionComponents(const State &st, const Move *moves, size_t n, CostStructure *costs, const std::vector<double> &weights = std::vector<double>(0)) const;
+
+  /** Computes the differences in the cost function obtained by applying the move @c mv to the state @c st, unless the move is proved to have a cost exceeding @c threshold. The components are evaluated in the order set by @ref SetComponentOrder, and the evaluation stops as soon as the partial variation plus the lower bounds of the remaining components (see @ref DeltaCostComponent::DeltaCostLowerBound) exceeds the threshold.
+       @note Early rejection requires a lower bound for each component that has not been evaluated yet, therefore it never happens when cost components without a delta implementation are attached, nor with cost structures which are not compared by a single value (e.g., @ref HierarchicalCostStructure). Explorers which redefine @ref DeltaCostFunctionComponents should redefine this method accordingly.
+       @param st the start state
+       @param mv the move
+       @param threshold the cost (weighted, if weights are given) above which the move is rejected
+       @param cost the computed cost (only if the move has not been rejected)
+       @return @c false if the move has been rejected
+       */
+  virtual bool BoundedDeltaCostFunctionComponents(const State &st, const Move &mv, double threshold, CostStructure &cost, const std::vector<double> &weights = std::vector<double>(0)) const;
+
+  /** Sets the order in which the delta cost components are evaluated.
+       @param order the evaluation order
+       */
+  void SetComponentOrder(ComponentOrder order)
+  {
+    component_order = order;
+    BuildComponentSlots();
+  }
+
+  /** Returns the maximum number of moves evaluated in a single batch. */
+  size_t BatchSize() const
+  {
+    return batch_size;
+  }
+
+  /** Sets the maximum number of moves evaluated in a single batch.
+       @param bs the new batch size (at least one)
+       */
+  void SetBatchSize(size_t bs)
+  {
+    if (bs == 0)
+      throw std::logic_error("The batch size should be greater than zero");
+    batch_size = bs;
+  }
+
   /** Adds a delta cost component to the neighborhood explorer, which is responsible for computing one component of the cost function. A delta cost component requires the implementation of a way to compute the difference in the cost function without simulating the move on a given state.
        @param dcc a delta cost component object
        */
@@ -137,6 +279,82 @@ public:
 
   virtual void AddCostComponent(CostComponent<Input, State, CFtype> &cc);
 
+  /** Resolves the position of each attached component in the cost structure, so that the evaluation of moves does not need to look them up in the state manager. It is invoked automatically when components are added and, if some of them were not registered in the state manager yet, upon the first evaluation.
+       @note It should be invoked explicitly before evaluating moves concurrently (e.g., from several threads) if the cost components have been registered in the state manager after being added to the explorer.
+       */
+  void ResolveComponentSlots() const;
+
+  /** Binds the explorer to the state @c st, and caches the costs on it of the cost components without a delta implementation (see @ref AddCostComponent), which are then reused whenever moves are evaluated on the very same state object. Each binding increases the state version (see @ref StateVersion).
+       @note The cached costs are validated only by the identity of the state object, therefore the caller (typically a runner) must bind the state again whenever it is modified, either in place (e.g., by a kicker or a solver editing the state of a runner) or by @ref MakeMove (by means of the overload below), otherwise the moves are evaluated against stale costs (in debug builds, i.e., without NDEBUG, the cached costs are checked against the state at each evaluation). The state is shared so that it is not deallocated while bound.
+       @param st the state to bind
+       */
+  void BindState(const std::shared_ptr<const State> &st);
+
+  /** Binds the explorer to the state @c st, which has been obtained from the currently bound one by applying the move @c performed. If move caching is enabled (see @ref SetMoveCaching), only the cached move costs invalidated by @c performed (see @ref MoveInvalidated) are dropped.
+       @param st the state to bind
+       @param performed the move which has been applied
+       */
+  void BindState(const std::shared_ptr<const State> &st, const Move &performed);
+
+  /** Unbinds the explorer from the current bound state (if any), dropping the cached costs and the scratch states of the threads (see @ref UndoMove). */
+  void UnbindState();
+
+  /** Enables or disables the memoization of the move costs computed by @ref SelectBest on the bound state. When the runner performs a move, only the costs of the moves which are invalidated by it (according to @ref MoveInvalidated) are recomputed at the next exploration. The moves are identified by their position in the exploration order, therefore @ref FirstMove and @ref NextMove must generate the moves of the unaffected part of the neighborhood in the same order at each iteration (a different move at the same position is detected and recomputed). All the costs are recomputed when the weights passed to @ref SelectBest or the weights of the cost components (see @ref CostComponent::SetWeight) change.
+       @note It is effective only if @ref MoveInvalidated is implemented, and only on the (serial) @ref SelectBest of this explorer.
+       @param enabled whether move caching should be used
+       */
+  void SetMoveCaching(bool enabled)
+  {
+    move_caching = enabled;
+    move_cache.Clear();
+  }
+
+  /** Returns whether the memoization of move costs is enabled. */
+  bool MoveCaching() const
+  {
+    return move_caching;
+  }
+
+  /** States whether the cost of the move @c mv might have been changed by the application of the move @c performed, which led to the state @c st. It must take into account all the cost components attached to the explorer. By default all moves are invalidated.
+       @note Can be implemented in the application (MayRedef), it is used only when move caching is enabled (see @ref SetMoveCaching)
+       @param st the state obtained by applying @c performed
+       @param mv a move whose cost has been cached
+       @param performed the move which has been applied
+       */
+  virtual bool MoveInvalidated(const State &st, const Move &mv, const Move &performed) const
+  {
+    return true;
+  }
+
+  /** Appends to @c affected the positions (see @ref MoveAt) of the moves whose cost might have been changed by the application of the move @c performed, which led to the state @c st. The moves at the other positions are kept by the caller along with their costs, therefore @ref MoveAt must generate at each of them, on @c st, the very same move it generated on the previous state (e.g., a move storing the old value of an item changed by @c performed must be appended). By default the affected moves are the ones for which @ref MoveInvalidated holds, which are found by generating the whole neighborhood, therefore an implementation enumerating them directly (e.g., the moves involving the items changed by @c performed) makes the updates proportional to their number.
+       @note Can be implemented in the application (MayRedef), together with @ref IsAffectedMovesImplemented, it is used only if @ref MoveAt is implemented (e.g., by the rejectionless mode of @ref AbstractSimulatedAnnealing)
+       @param st the state obtained by applying @c performed
+       @param performed the move which has been applied
+       @param affected the positions of the affected moves
+       */
+  virtual void AffectedMoves(const State &st, const Move &performed, std::vector<size_t> &affected) const
+  {
+    Move mv;
+    for (size_t i = 0, n = NeighborhoodSize(st); i < n; i++)
+    {
+      MoveAt(st, i, mv);
+      if (MoveInvalidated(st, mv, performed))
+        affected.push_back(i);
+    }
+  }
+
+  /** Returns whether @ref AffectedMoves is implemented in the application, i.e., whether the affected moves are enumerated without generating the whole neighborhood. */
+  virtual bool IsAffectedMovesImplemented() const
+  {
+    return false;
+  }
+
+  /** Returns the version of the bound state, which changes at each call of @ref BindState (and not when the state is modified without binding it again). */
+  unsigned long StateVersion() const
+  {
+    return state_version;
+  }
+
   /** Returns the number of delta cost components attached to the neighborhood explorer.
        @return the size of the delta cost components vector
        */
@@ -188,6 +406,13 @@ public:
        */
   virtual EvaluatedMove<Move, CostStructure> RandomFirst(const State &st, size_t samples, size_t &explored, const MoveAcceptor &AcceptMove, const std::vector<double> &weights = std::vector<double>(0)) const;
 
+  /**
+       This method will select the first move in a random neighborhood exploration that
+       matches with the criterion expressed by the functional object bool f(const Move& mv, CostStructure cost).
+       Before the evaluation of each move a threshold is drawn by calling @c Threshold, and the moves proved to exceed it are rejected without completing their evaluation (see @ref BoundedDeltaCostFunctionComponents). The threshold is then passed to the acceptance criterion.
+       */
+  virtual EvaluatedMove<Move, CostStructure> RandomFirst(const State &st, size_t samples, size_t &explored, const ThresholdMoveAcceptor &AcceptMove, const MoveThreshold &Threshold, const std::vector<double> &weights = std::vector<double>(0)) const;
+
   /**
        This method will select the best move in a random neighborhood exploration that
        matches with the criterion expressed by the functional object bool f(const Move& mv, CostStructure cost)
@@ -209,13 +434,149 @@ protected:
 
   /** States whether there are unimplemented delta cost components attached */
   bool unimplemented_hard_components, unimplemented_soft_components;
+
+  /** Maximum number of moves evaluated in a single batch */
+  size_t batch_size;
+
+  /** An entry of the flat evaluation table of the explorer, which stores the component together with its precomputed position in the cost structure */
+  struct ComponentSlot
+  {
+    DeltaCostComponent<Input, State, Move, CFtype> *dcc;
+    size_t index;
+    bool is_hard, is_bounded;
+  };
+
+  /** Evaluation tables of the (hard first, then soft) implemented delta cost components and of the adapters of the unimplemented ones */
+  mutable std::vector<ComponentSlot> delta_slots, adapter_slots;
+
+  /** States whether the positions of all the components in the evaluation tables have been resolved */
+  mutable bool slots_resolved;
+
+  /** The order in which the delta cost components are evaluated */
+  ComponentOrder component_order;
+
+  /** States whether some of the delta cost components provide a lower bound */
+  bool bounded_components;
+
+  /** Rebuilds the evaluation tables from the lists of delta cost components. */
+  void BuildComponentSlots();
+
+  /** The state bound to the explorer (see @ref BindState) */
+  std::shared_ptr<const State> bound_state;
+
+  /** Costs on the bound state of the unimplemented delta cost components (in the order of @c adapter_slots) */
+  std::vector<CFtype> bound_state_costs;
+
+  /** Version of the bound state */
+  unsigned long state_version;
+
+  /** Memoized costs of the moves on the bound state, indexed by their position in the exploration order */
+  struct MoveCostCache
+  {
+    void Clear()
+    {
+      valid.assign(valid.size(), false);
+    }
+    std::vector<Move> moves;
+    std::vector<CostStructure> costs;
+    std::vector<bool> valid;
+    std::vector<double> weights; /**< The weights the costs have been computed with */
+    std::vector<CFtype> component_weights; /**< The weights of the cost components (see @ref CostComponent::SetWeight) the costs have been computed with, in the order of @c delta_slots and @c adapter_slots */
+  };
+
+  /** Whether move caching is enabled */
+  bool move_caching;
+
+  /** The cache of the move costs (see @ref SetMoveCaching) */
+  mutable MoveCostCache move_cache;
+
+  /** Returns whether the weights or the weights of the cost components have changed since the cached costs have been computed, and records the current ones. */
+  bool MoveCacheWeightsChanged(const std::vector<double> &weights) const;
+
+  /** Evaluates a batch of moves, starting at position @c position of the exploration of the bound state, reusing the cached costs. */
+  void CachedBatchDeltaCostFunctionComponents(const State &st, size_t position, const Move *moves, size_t n, CostStructure *costs, const std::vector<double> &weights) const;
+
+  /** Returns the batch buffer of the calling thread, which is reused across explorations. */
+  static MoveBatch<Move, CostStructure> &LocalBatch()
+  {
+    static thread_local MoveBatch<Move, CostStructure> batch;
+    return batch;
+  }
+
+  /** A modifiable copy of a state, on which moves are applied and reverted by means of @ref UndoMove */
+  struct ScratchState
+  {
+    ScratchState() : source(nullptr) {}
+    std::unique_ptr<State> state;
+    const State *source; /**< The state it is currently a copy of (if any) */
+  };
+
+  /** Returns the scratch state of the calling thread, which is owned by the explorer (and freed by @ref UnbindState). Each thread remembers the last one it has used, so that the explorer is looked up (under a lock) only when the thread switches explorer, or after the states are freed. */
+  ScratchState &LocalScratch() const
+  {
+    struct LastScratch
+    {
+      unsigned long generation;
+      ScratchState *scratch;
+    };
+    static thread_local LastScratch last = {0, nullptr};
+    const unsigned long generation = scratch_generation.load(std::memory_order_acquire);
+    if (last.generation == generation)
+      return *last.scratch;
+    std::lock_guard<std::mutex> lock(scratch_mutex);
+    std::unique_ptr<ScratchState> &scratch = scratch_states[std::this_thread::get_id()];
+    if (!scratch)
+      scratch.reset(new ScratchState());
+    last = {generation, scratch.get()};
+    return *scratch;
+  }
+
+  /** Returns a generation of scratch states never used before, by any explorer. */
+  static unsigned long NewScratchGeneration()
+  {
+    static std::atomic<unsigned long> next_generation(1);
+    return next_generation++;
+  }
+
+  /** Frees the scratch states of all the threads (no move must be under evaluation). */
+  void FreeScratchStates()
+  {
+    std::lock_guard<std::mutex> lock(scratch_mutex);
+    scratch_states.clear();
+    scratch_generation.store(NewScratchGeneration(), std::memory_order_release);
+  }
+
+  /** The scratch states of the threads which have evaluated moves through the explorer */
+  mutable std::unordered_map<std::thread::id, std::unique_ptr<ScratchState>> scratch_states;
+  mutable std::mutex scratch_mutex;
+  /** Identifies the current scratch states, so that the threads do not use the ones freed */
+  std::atomic<unsigned long> scratch_generation;
+
+  /** Makes the scratch state of the calling thread a copy of @c st, until @ref ReleaseScratchState is called.
+       @return @c false if the scratch state was already a copy of @c st (and nothing has been done)
+       */
+  bool AcquireScratchState(const State &st) const;
+
+  /** Marks the scratch state of the calling thread as not being a copy of any state. */
+  void ReleaseScratchState() const;
+
+  /** Computes the (unweighted) difference of the cost component @c cc due to the application of @c mv to @c st, through the scratch state if @ref UndoMove is available, or on a copy of the state otherwise. */
+  CFtype CostComponentDifference(const CostComponent<Input, State, CFtype> &cc, const State &st, const Move &mv) const;
+
+  /** Returns the cost of the component @c cc on the state @c st, which is taken from the cache if @c st is the bound state. */
+  CFtype BaseCost(const CostComponent<Input, State, CFtype> &cc, const State &st) const;
+
+  /** Accumulates the delta costs of the unimplemented delta cost components, given the start state and the state obtained by applying the move. */
+  void AdapterDeltaCost(const State &st, const State &new_st, const std::vector<double> &weights, typename CostStructure::ComponentsType &delta_cost_function, CFtype &delta_hard_cost, CFtype &delta_soft_cost, double &delta_weighted_cost) const;
+
+  friend class DeltaCostComponentAdapter<Input, State, Move, CostStructure>;
 };
 
 /** IMPLEMENTATION */
 
 template <class Input, class State, class Move, class CostStructure>
 NeighborhoodExplorer<Input, State, Move, CostStructure>::NeighborhoodExplorer(const Input &i, StateManager<Input, State, CostStructure> &e_sm, std::string e_name)
-    : in(i), sm(e_sm), name(e_name), unimplemented_hard_components(false), unimplemented_soft_components(false)
+    : in(i), sm(e_sm), name(e_name), unimplemented_hard_components(false), unimplemented_soft_components(false), batch_size(64), slots_resolved(true), component_order(ComponentOrder::HardFirst), bounded_components(false), state_version(0), move_caching(false), scratch_generation(NewScratchGeneration())
 {
 }
 
@@ -229,66 +590,57 @@ CostStructure NeighborhoodExplorer<Input, State, Move, CostStructure>::DeltaCost
 {
   CFtype delta_hard_cost = 0, delta_soft_cost = 0;
   double delta_weighted_cost = 0.0;
-  std::vector<CFtype> delta_cost_function(sm.CostComponents(), static_cast<CFtype>(0));
+  typename CostStructure::ComponentsType delta_cost_function(sm.CostComponents(), static_cast<CFtype>(0));
+
+  if (!slots_resolved)
+    ResolveComponentSlots();
 
-  for (size_t i = 0; i < delta_hard_cost_components.size(); i++)
+  for (const ComponentSlot &slot : delta_slots)
   {
-    auto dcc = delta_hard_cost_components[i];
-    if (dcc->IsDeltaImplemented())
+    CFtype current_delta_cost = delta_cost_function[slot.index] = slot.dcc->DeltaCost(st, mv);
+    if (slot.is_hard)
     {
-      CFtype current_delta_cost = delta_cost_function[sm.CostComponentIndex(dcc->cc)] = dcc->DeltaCost(st, mv);
       delta_hard_cost += current_delta_cost;
       if (!weights.empty())
-        delta_weighted_cost += HARD_WEIGHT * weights[sm.CostComponentIndex(dcc->cc)] * current_delta_cost;
+        delta_weighted_cost += HARD_WEIGHT * weights[slot.index] * current_delta_cost;
     }
-  }
-  for (size_t i = 0; i < delta_soft_cost_components.size(); i++)
-  {
-    auto dcc = delta_soft_cost_components[i];
-    if (dcc->IsDeltaImplemented())
+    else
     {
-      CFtype current_delta_cost = delta_cost_function[sm.CostComponentIndex(dcc->cc)] = dcc->DeltaCost(st, mv);
       delta_soft_cost += current_delta_cost;
       if (!weights.empty())
-        delta_weighted_cost += weights[sm.CostComponentIndex(dcc->cc)] * current_delta_cost;
+        delta_weighted_cost += weights[slot.index] * current_delta_cost;
     }
   }
 
   // only if there is at least one unimplemented delta cost component (i.e., a wrapper along a cost component)
-  if (unimplemented_hard_components || unimplemented_soft_components)
+  if (!adapter_slots.empty())
   {
-    // compute move
-    State new_st = st;
-    MakeMove(new_st, mv);
-
-    if (unimplemented_hard_components)
-      for (size_t i = 0; i < delta_hard_cost_components.size(); i++)
+    if (IsUndoImplemented())
+    {
+      // apply the move on the scratch state and revert it afterwards (the scratch is already a copy of st within a batch)
+      bool acquired = AcquireScratchState(st);
+      State &new_st = *LocalScratch().state;
+      try
       {
-        auto dcc = delta_hard_cost_components[i];
-        if (!dcc->IsDeltaImplemented())
-        {
-          // get reference to cost component
-          auto &cc = dcc->GetCostComponent();
-          CFtype current_delta_cost = delta_cost_function[sm.CostComponentIndex(cc)] = cc.Weight() * (cc.ComputeCost(new_st) - cc.ComputeCost(st));
-          delta_hard_cost += current_delta_cost;
-          if (!weights.empty())
-            delta_weighted_cost += HARD_WEIGHT * weights[sm.CostComponentIndex(cc)] * current_delta_cost;
-        }
+        MakeMove(new_st, mv);
+        AdapterDeltaCost(st, new_st, weights, delta_cost_function, delta_hard_cost, delta_soft_cost, delta_weighted_cost);
+        UndoMove(new_st, mv);
       }
-    if (unimplemented_soft_components)
-      for (size_t i = 0; i < delta_soft_cost_components.size(); i++)
+      catch (...)
       {
-        auto dcc = delta_soft_cost_components[i];
-        if (!dcc->IsDeltaImplemented())
-        {
-          // get reference to cost component
-          auto &cc = dcc->GetCostComponent();
-          CFtype current_delta_cost = delta_cost_function[sm.CostComponentIndex(cc)] = cc.Weight() * (cc.ComputeCost(new_st) - cc.ComputeCost(st));
-          delta_soft_cost += current_delta_cost;
-          if (!weights.empty())
-            delta_weighted_cost += weights[sm.CostComponentIndex(cc)] * current_delta_cost;
-        }
+        ReleaseScratchState(); // the scratch state could be inconsistent
+        throw;
       }
+      if (acquired)
+        ReleaseScratchState();
+    }
+    else
+    {
+      // compute move
+      State new_st = st;
+      MakeMove(new_st, mv);
+      AdapterDeltaCost(st, new_st, weights, delta_cost_function, delta_hard_cost, delta_soft_cost, delta_weighted_cost);
+    }
   }
 
   if (!weights.empty())
@@ -297,6 +649,244 @@ CostStructure NeighborhoodExplorer<Input, State, Move, CostStructure>::DeltaCost
     return CostStructure(HARD_WEIGHT * delta_hard_cost + delta_soft_cost, delta_hard_cost, delta_soft_cost, delta_cost_function);
 }
 
+template <class Input, class State, class Move, class CostStructure>
+void NeighborhoodExplorer<Input, State, Move, CostStructure>::BatchDeltaCostFunctionComponents(const State &st, const Move *moves, size_t n, CostStructure *costs, const std::vector<double> &weights) const
+{
+  // the scratch state (if used) is copied once for the whole batch
+  bool acquired = !adapter_slots.empty() && IsUndoImplemented() && AcquireScratchState(st);
+  try
+  {
+    for (size_t i = 0; i < n; i++)
+      costs[i] = DeltaCostFunctionComponents(st, moves[i], weights);
+  }
+  catch (...)
+  {
+    if (acquired)
+      ReleaseScratchState();
+    throw;
+  }
+  if (acquired)
+    ReleaseScratchState();
+}
+
+template <class Input, class State, class Move, class CostStructure>
+bool NeighborhoodExplorer<Input, State, Move, CostStructure>::BoundedDeltaCostFunctionComponents(const State &st, const Move &mv, double threshold, CostStructure &cost, const std::vector<double> &weights) const
+{
+  if (!slots_resolved)
+    ResolveComponentSlots();
+
+  // early rejection is possible only if all the components not yet evaluated are bounded
+  if (!IsScalarCostStructure<CostStructure>::value || !bounded_components || !adapter_slots.empty() || threshold == std::numeric_limits<double>::infinity())
+  {
+    cost = DeltaCostFunctionComponents(st, mv, weights);
+    return true;
+  }
+
+  // lower bounds of the contributions of the components to the total (or weighted) cost
+  static thread_local std::vector<double> lower_bounds;
+  lower_bounds.resize(delta_slots.size());
+  double remaining_bound = 0.0, partial_cost = 0.0;
+  size_t unbounded = 0;
+  for (size_t i = 0; i < delta_slots.size(); i++)
+  {
+    const ComponentSlot &slot = delta_slots[i];
+    double factor = (slot.is_hard ? HARD_WEIGHT : 1) * (weights.empty() ? 1.0 : weights[slot.index]) * slot.dcc->GetCostComponent().Weight();
+    if (slot.is_bounded && factor >= 0.0)
+    {
+      lower_bounds[i] = factor * slot.dcc->DeltaCostLowerBound(st, mv);
+      remaining_bound += lower_bounds[i];
+    }
+    else
+    {
+      lower_bounds[i] = -std::numeric_limits<double>::infinity();
+      unbounded++;
+    }
+  }
+  if (unbounded == 0 && GreaterThan(remaining_bound, threshold))
+    return false;
+
+  CFtype delta_hard_cost = 0, delta_soft_cost = 0;
+  double delta_weighted_cost = 0.0;
+  typename CostStructure::ComponentsType delta_cost_function(sm.CostComponents(), static_cast<CFtype>(0));
+  for (size_t i = 0; i < delta_slots.size(); i++)
+  {
+    const ComponentSlot &slot = delta_slots[i];
+    CFtype current_delta_cost = delta_cost_function[slot.index] = slot.dcc->DeltaCost(st, mv);
+    if (slot.is_hard)
+    {
+      delta_hard_cost += current_delta_cost;
+      if (!weights.empty())
+        delta_weighted_cost += HARD_WEIGHT * weights[slot.index] * current_delta_cost;
+    }
+    else
+    {
+      delta_soft_cost += current_delta_cost;
+      if (!weights.empty())
+        delta_weighted_cost += weights[slot.index] * current_delta_cost;
+    }
+    if (lower_bounds[i] == -std::numeric_limits<double>::infinity())
+      unbounded--;
+    else
+      remaining_bound -= lower_bounds[i];
+    partial_cost = weights.empty() ? static_cast<double>(HARD_WEIGHT * delta_hard_cost + delta_soft_cost) : delta_weighted_cost;
+    if (unbounded == 0 && i + 1 < delta_slots.size() && GreaterThan(partial_cost + remaining_bound, threshold))
+      return false;
+  }
+
+  if (!weights.empty())
+    cost = CostStructure(HARD_WEIGHT * delta_hard_cost + delta_soft_cost, delta_weighted_cost, delta_hard_cost, delta_soft_cost, delta_cost_function);
+  else
+    cost = CostStructure(HARD_WEIGHT * delta_hard_cost + delta_soft_cost, delta_hard_cost, delta_soft_cost, delta_cost_function);
+  return true;
+}
+
+template <class Input, class State, class Move, class CostStructure>
+bool NeighborhoodExplorer<Input, State, Move, CostStructure>::MoveCacheWeightsChanged(const std::vector<double> &weights) const
+{
+  bool changed = move_cache.weights != weights;
+  if (changed)
+    move_cache.weights = weights;
+  const size_t components = delta_slots.size() + adapter_slots.size();
+  if (move_cache.component_weights.size() != components)
+  {
+    move_cache.component_weights.assign(components, CFtype());
+    changed = true;
+  }
+  size_t k = 0;
+  for (auto slots : {&delta_slots, &adapter_slots})
+    for (const ComponentSlot &slot : *slots)
+    {
+      const CFtype w = slot.dcc->GetCostComponent().Weight();
+      if (move_cache.component_weights[k] != w)
+      {
+        move_cache.component_weights[k] = w;
+        changed = true;
+      }
+      k++;
+    }
+  return changed;
+}
+
+template <class Input, class State, class Move, class CostStructure>
+void NeighborhoodExplorer<Input, State, Move, CostStructure>::CachedBatchDeltaCostFunctionComponents(const State &st, size_t position, const Move *moves, size_t n, CostStructure *costs, const std::vector<double> &weights) const
+{
+  if (move_cache.valid.size() < position + n)
+  {
+    move_cache.moves.resize(position + n);
+    move_cache.costs.resize(position + n);
+    move_cache.valid.resize(position + n, false);
+  }
+  size_t i = 0;
+  while (i < n)
+  {
+    if (move_cache.valid[position + i] && move_cache.moves[position + i] == moves[i])
+    {
+      costs[i] = move_cache.costs[position + i];
+      i++;
+      continue;
+    }
+    // evaluates the whole run of moves which are not in the cache at once
+    size_t j = i + 1;
+    while (j < n && !(move_cache.valid[position + j] && move_cache.moves[position + j] == moves[j]))
+      j++;
+    BatchDeltaCostFunctionComponents(st, moves + i, j - i, costs + i, weights);
+    for (; i < j; i++)
+    {
+      move_cache.moves[position + i] = moves[i];
+      move_cache.costs[position + i] = costs[i];
+      move_cache.valid[position + i] = true;
+    }
+  }
+}
+
+template <class Input, class State, class Move, class CostStructure>
+bool NeighborhoodExplorer<Input, State, Move, CostStructure>::AcquireScratchState(const State &st) const
+{
+  ScratchState &scratch = LocalScratch();
+  if (scratch.source == &st)
+    return false;
+  if (!scratch.state)
+    scratch.state.reset(new State(st));
+  else
+    *scratch.state = st;
+  scratch.source = &st;
+  return true;
+}
+
+template <class Input, class State, class Move, class CostStructure>
+void NeighborhoodExplorer<Input, State, Move, CostStructure>::ReleaseScratchState() const
+{
+  LocalScratch().source = nullptr;
+}
+
+template <class Input, class State, class Move, class CostStructure>
+typename CostStructure::CFtype NeighborhoodExplorer<Input, State, Move, CostStructure>::CostComponentDifference(const CostComponent<Input, State, CFtype> &cc, const State &st, const Move &mv) const
+{
+  if (!IsUndoImplemented())
+  {
+    State new_st = st;
+    MakeMove(new_st, mv);
+    return cc.ComputeCost(new_st) - BaseCost(cc, st);
+  }
+  bool acquired = AcquireScratchState(st);
+  State &new_st = *LocalScratch().state;
+  CFtype difference;
+  try
+  {
+    MakeMove(new_st, mv);
+    difference = cc.ComputeCost(new_st) - BaseCost(cc, st);
+    UndoMove(new_st, mv);
+  }
+  catch (...)
+  {
+    ReleaseScratchState(); // the scratch state could be inconsistent
+    throw;
+  }
+  if (acquired)
+    ReleaseScratchState();
+  return difference;
+}
+
+template <class Input, class State, class Move, class CostStructure>
+typename CostStructure::CFtype NeighborhoodExplorer<Input, State, Move, CostStructure>::BaseCost(const CostComponent<Input, State, CFtype> &cc, const State &st) const
+{
+  if (bound_state.get() == &st)
+    for (size_t i = 0; i < adapter_slots.size(); i++)
+      if (&adapter_slots[i].dcc->GetCostComponent() == &cc)
+      {
+        assert(bound_state_costs[i] == cc.ComputeCost(st) && "the bound state has been modified without binding it again");
+        return bound_state_costs[i];
+      }
+  return cc.ComputeCost(st);
+}
+
+template <class Input, class State, class Move, class CostStructure>
+void NeighborhoodExplorer<Input, State, Move, CostStructure>::AdapterDeltaCost(const State &st, const State &new_st, const std::vector<double> &weights, typename CostStructure::ComponentsType &delta_cost_function, CFtype &delta_hard_cost, CFtype &delta_soft_cost, double &delta_weighted_cost) const
+{
+  // the costs on the start state are cached if it is the bound one
+  const bool bound = bound_state.get() == &st;
+  for (size_t i = 0; i < adapter_slots.size(); i++)
+  {
+    const ComponentSlot &slot = adapter_slots[i];
+    // get reference to cost component
+    auto &cc = slot.dcc->GetCostComponent();
+    assert((!bound || bound_state_costs[i] == cc.ComputeCost(st)) && "the bound state has been modified without binding it again");
+    CFtype current_delta_cost = delta_cost_function[slot.index] = cc.Weight() * (cc.ComputeCost(new_st) - (bound ? bound_state_costs[i] : cc.ComputeCost(st)));
+    if (slot.is_hard)
+    {
+      delta_hard_cost += current_delta_cost;
+      if (!weights.empty())
+        delta_weighted_cost += HARD_WEIGHT * weights[slot.index] * current_delta_cost;
+    }
+    else
+    {
+      delta_soft_cost += current_delta_cost;
+      if (!weights.empty())
+        delta_weighted_cost += weights[slot.index] * current_delta_cost;
+    }
+  }
+}
+
 template <class Input, class State, class Move, class CostStructure>
 void NeighborhoodExplorer<Input, State, Move, CostStructure>::AddDeltaCostComponent(DeltaCostComponent<Input, State, Move, CFtype> &dcc)
 {
@@ -304,6 +894,7 @@ void NeighborhoodExplorer<Input, State, Move, CostStructure>::AddDeltaCostCompon
     delta_hard_cost_components.push_back(&dcc);
   else
     delta_soft_cost_components.push_back(&dcc);
+  BuildComponentSlots();
 }
 
 template <class Input, class State, class Move, class CostStructure>
@@ -321,58 +912,165 @@ void NeighborhoodExplorer<Input, State, Move, CostStructure>::AddCostComponent(C
     unimplemented_soft_components = true;
     delta_soft_cost_components.push_back(dcc_adapters[dcc_adapters.size() - 1].get());
   }
+  BuildComponentSlots();
+}
+
+template <class Input, class State, class Move, class CostStructure>
+void NeighborhoodExplorer<Input, State, Move, CostStructure>::BuildComponentSlots()
+{
+  UnbindState();
+  delta_slots.clear();
+  adapter_slots.clear();
+  // the tables preserve the evaluation order: hard components first, then soft ones
+  for (auto dcc : delta_hard_cost_components)
+    (dcc->IsDeltaImplemented() ? delta_slots : adapter_slots).push_back({dcc, 0, true, dcc->IsDeltaBounded()});
+  for (auto dcc : delta_soft_cost_components)
+    (dcc->IsDeltaImplemented() ? delta_slots : adapter_slots).push_back({dcc, 0, false, dcc->IsDeltaBounded()});
+  if (component_order == ComponentOrder::CheapestFirst)
+    std::stable_sort(delta_slots.begin(), delta_slots.end(), [](const ComponentSlot &s1, const ComponentSlot &s2) {
+      return s1.dcc->EvaluationCost() < s2.dcc->EvaluationCost();
+    });
+  bounded_components = std::any_of(delta_slots.begin(), delta_slots.end(), [](const ComponentSlot &slot) { return slot.is_bounded; });
+  slots_resolved = false;
+  for (auto slots : {&delta_slots, &adapter_slots})
+    for (const ComponentSlot &slot : *slots)
+      if (!sm.HasCostComponent(slot.dcc->GetCostComponent()))
+        return; // resolution is deferred to the first evaluation
+  ResolveComponentSlots();
+}
+
+template <class Input, class State, class Move, class CostStructure>
+void NeighborhoodExplorer<Input, State, Move, CostStructure>::BindState(const std::shared_ptr<const State> &st, const Move &performed)
+{
+  if (!move_caching || st != bound_state)
+  {
+    BindState(st);
+    return;
+  }
+  for (size_t i = 0; i < move_cache.valid.size(); i++)
+    if (move_cache.valid[i] && MoveInvalidated(*st, move_cache.moves[i], performed))
+      move_cache.valid[i] = false;
+  for (size_t i = 0; i < adapter_slots.size(); i++)
+    bound_state_costs[i] = adapter_slots[i].dcc->GetCostComponent().ComputeCost(*st);
+  state_version++;
+}
+
+template <class Input, class State, class Move, class CostStructure>
+void NeighborhoodExplorer<Input, State, Move, CostStructure>::BindState(const std::shared_ptr<const State> &st)
+{
+  move_cache.Clear();
+  bound_state = st;
+  bound_state_costs.resize(adapter_slots.size());
+  for (size_t i = 0; i < adapter_slots.size(); i++)
+    bound_state_costs[i] = adapter_slots[i].dcc->GetCostComponent().ComputeCost(*st);
+  state_version++;
+}
+
+template <class Input, class State, class Move, class CostStructure>
+void NeighborhoodExplorer<Input, State, Move, CostStructure>::UnbindState()
+{
+  move_cache.Clear();
+  bound_state.reset();
+  bound_state_costs.clear();
+  FreeScratchStates();
+}
+
+template <class Input, class State, class Move, class CostStructure>
+void NeighborhoodExplorer<Input, State, Move, CostStructure>::ResolveComponentSlots() const
+{
+  for (auto slots : {&delta_slots, &adapter_slots})
+    for (ComponentSlot &slot : *slots)
+      slot.index = sm.CostComponentIndex(slot.dcc->GetCostComponent());
+  slots_resolved = true;
 }
 
 /**
      This method will select the first move in the exhaustive neighborhood exploration that
      matches with the criterion expressed by the functional object bool f(const Move& mv, CostStructure cost)
+     @remarks moves are evaluated in batches whose size doubles up to @ref BatchSize, therefore the moves following the accepted one in its batch (fewer than @ref BatchSize) are evaluated as well, and they are counted in @c explored
      */
 template <class Input, class State, class Move, class CostStructure>
 EvaluatedMove<Move, CostStructure> NeighborhoodExplorer<Input, State, Move, CostStructure>::SelectFirst(const State &st, size_t &explored, const MoveAcceptor &AcceptMove, const std::vector<double> &weights) const
 {
+  MoveBatch<Move, CostStructure> &batch = LocalBatch();
+  const CancellationToken token = CancellationToken::Current();
+  size_t current_batch_size = 1;
+  bool last_move = false;
+  Move mv;
   explored = 0;
-  EvaluatedMove<Move, CostStructure> mv;
-  FirstMove(st, mv.move);
-  do
+  FirstMove(st, mv);
+  while (!last_move)
   {
-    mv.cost = DeltaCostFunctionComponents(st, mv.move, weights);
-    explored++;
-    mv.is_valid = true;
-
-    if (AcceptMove(mv.move, mv.cost))
-      return mv; // mv passes the acceptance criterion
-  } while (NextMove(st, mv.move));
+    size_t n = 0;
+    batch.Reserve(current_batch_size);
+    do
+    {
+      batch.moves[n++] = mv;
+      last_move = !NextMove(st, mv);
+    } while (!last_move && n < current_batch_size);
+    BatchDeltaCostFunctionComponents(st, batch.moves.data(), n, batch.costs.data(), weights);
+    explored += n; // including the moves following the accepted one, which have been evaluated as well
+    for (size_t i = 0; i < n; i++)
+      if (AcceptMove(batch.moves[i], batch.costs[i]))
+        return EvaluatedMove<Move, CostStructure>(batch.moves[i], batch.costs[i]); // mv passes the acceptance criterion
+    current_batch_size = std::min(2 * current_batch_size, batch_size);
+    if (token.IsCancelled())
+      break;
+  }
 
   // exiting this loop means that there is no mv passing the acceptance criterion
   return EvaluatedMove<Move, CostStructure>::empty;
 }
-  
-  template <class Input, class State, class Move, class CostStructure>
-  EvaluatedMove<Move, CostStructure> NeighborhoodExplorer<Input, State, Move, CostStructure>::SelectFirst(const Move& start_move, const State &st, size_t &explored, const MoveAcceptor &AcceptMove, const std::vector<double> &weights) const
+
+/**
+     This method will select the first move in the exhaustive neighborhood exploration that
+     matches with the criterion expressed by the functional object bool f(const Move& mv, CostStructure cost).
+     The exploration starts from the move following @c start_move, wraps around the end of the neighborhood and terminates with @c start_move itself.
+     @remarks moves are evaluated in batches as in the other SelectFirst, and all the evaluated moves are counted in @c explored
+     */
+template <class Input, class State, class Move, class CostStructure>
+EvaluatedMove<Move, CostStructure> NeighborhoodExplorer<Input, State, Move, CostStructure>::SelectFirst(const Move &start_move, const State &st, size_t &explored, const MoveAcceptor &AcceptMove, const std::vector<double> &weights) const
+{
+  MoveBatch<Move, CostStructure> &batch = LocalBatch();
+  const CancellationToken token = CancellationToken::Current();
+  size_t current_batch_size = 1;
+  bool last_move = false, wrapped = false;
+  Move mv = start_move;
+  explored = 0;
+  while (!last_move)
   {
-    explored = 0;
-    EvaluatedMove<Move, CostStructure> mv;
-    mv.move = start_move;
-    unsigned int rounds = 0;
+    size_t n = 0;
+    batch.Reserve(current_batch_size);
     do
     {
-      while (NextMove(st, mv.move))
+      if (!NextMove(st, mv))
       {
-        mv.cost = DeltaCostFunctionComponents(st, mv.move, weights);
-        explored++;
-        mv.is_valid = true;
-        
-        if (AcceptMove(mv.move, mv.cost))
-          return mv; // mv passes the acceptance criterion
+        if (wrapped) // start_move is not in the neighborhood, stop after a full round
+        {
+          last_move = true;
+          break;
+        }
+        FirstMove(st, mv);
+        wrapped = true;
       }
-      rounds++;
-    }
-    while (mv.move != start_move || rounds > 1); // TODO: possibly explores some moves twice
-    
-    // exiting this loop means that there is no mv passing the acceptance criterion
-    return EvaluatedMove<Move, CostStructure>::empty;
+      batch.moves[n++] = mv;
+      last_move = (mv == start_move);
+    } while (!last_move && n < current_batch_size);
+    if (n == 0)
+      break;
+    BatchDeltaCostFunctionComponents(st, batch.moves.data(), n, batch.costs.data(), weights);
+    explored += n; // including the moves following the accepted one, which have been evaluated as well
+    for (size_t i = 0; i < n; i++)
+      if (AcceptMove(batch.moves[i], batch.costs[i]))
+        return EvaluatedMove<Move, CostStructure>(batch.moves[i], batch.costs[i]); // mv passes the acceptance criterion
+    current_batch_size = std::min(2 * current_batch_size, batch_size);
+    if (token.IsCancelled())
+      break;
   }
-  
+
+  // exiting this loop means that there is no mv passing the acceptance criterion
+  return EvaluatedMove<Move, CostStructure>::empty;
+}
 
 /**
      This method will select the best move in the exhaustive neighborhood exploration that
@@ -381,36 +1079,56 @@ EvaluatedMove<Move, CostStructure> NeighborhoodExplorer<Input, State, Move, Cost
 template <class Input, class State, class Move, class CostStructure>
 EvaluatedMove<Move, CostStructure> NeighborhoodExplorer<Input, State, Move, CostStructure>::SelectBest(const State &st, size_t &explored, const MoveAcceptor &AcceptMove, const std::vector<double> &weights) const
 {
+  MoveBatch<Move, CostStructure> &batch = LocalBatch();
+  const CancellationToken token = CancellationToken::Current();
   unsigned int number_of_bests = 0; // number of moves found with the same best value
+  bool last_move = false;
+  Move mv;
+  EvaluatedMove<Move, CostStructure> best_move;
+  const bool cached = move_caching && bound_state.get() == &st;
+  if (cached && MoveCacheWeightsChanged(weights))
+    move_cache.Clear();
   explored = 0;
-  EvaluatedMove<Move, CostStructure> mv, best_move;
-  FirstMove(st, mv.move);
-
-  do
+  batch.Reserve(batch_size);
+  FirstMove(st, mv);
+  while (!last_move)
   {
-    mv.cost = DeltaCostFunctionComponents(st, mv.move, weights);
-    explored++;
-    mv.is_valid = true;
-    if (AcceptMove(mv.move, mv.cost))
+    size_t n = 0;
+    do
     {
-      if (number_of_bests == 0)
-      {
-        best_move = mv;
-        number_of_bests = 1;
-      }
-      else if (mv.cost < best_move.cost)
-      {
-        best_move = mv;
-        number_of_bests = 1;
-      }
-      else if (mv.cost == best_move.cost)
+      batch.moves[n++] = mv;
+      last_move = !NextMove(st, mv);
+    } while (!last_move && n < batch_size);
+    if (cached)
+      CachedBatchDeltaCostFunctionComponents(st, explored, batch.moves.data(), n, batch.costs.data(), weights);
+    else
+      BatchDeltaCostFunctionComponents(st, batch.moves.data(), n, batch.costs.data(), weights);
+    explored += n;
+    for (size_t i = 0; i < n; i++)
+    {
+      if (AcceptMove(batch.moves[i], batch.costs[i]))
       {
-        if (Random::Uniform<unsigned int>(0, number_of_bests) == 0) // accept the move with probability 1 / (1 + number_of_bests)
-          best_move = mv;
-        number_of_bests++;
+        if (number_of_bests == 0)
+        {
+          best_move = EvaluatedMove<Move, CostStructure>(batch.moves[i], batch.costs[i]);
+          number_of_bests = 1;
+        }
+        else if (batch.costs[i] < best_move.cost)
+        {
+          best_move = EvaluatedMove<Move, CostStructure>(batch.moves[i], batch.costs[i]);
+          number_of_bests = 1;
+        }
+        else if (batch.costs[i] == best_move.cost)
+        {
+          if (Random::Uniform<unsigned int>(0, number_of_bests) == 0) // accept the move with probability 1 / (1 + number_of_bests)
+            best_move = EvaluatedMove<Move, CostStructure>(batch.moves[i], batch.costs[i]);
+          number_of_bests++;
+        }
       }
     }
-  } while (NextMove(st, mv.move));
+    if (token.IsCancelled())
+      break;
+  }
 
   if (number_of_bests == 0)
     return EvaluatedMove<Move, CostStructure>::empty;
@@ -421,61 +1139,100 @@ EvaluatedMove<Move, CostStructure> NeighborhoodExplorer<Input, State, Move, Cost
 /**
      This method will select the first move in the random neighborhood exploration that
      matches with the criterion expressed by the functional object bool f(const Move& mv, CostStructure cost)
+     @remarks moves are intentionally drawn and evaluated one at a time (as batches of one move): drawing a batch ahead would consume the random stream past the accepted move, and it would interleave the draws of the moves and the ones of a stochastic acceptance criterion differently
      */
 template <class Input, class State, class Move, class CostStructure>
 EvaluatedMove<Move, CostStructure> NeighborhoodExplorer<Input, State, Move, CostStructure>::RandomFirst(const State &st, size_t samples, size_t &explored, const MoveAcceptor &AcceptMove, const std::vector<double> &weights) const
 {
-  EvaluatedMove<Move, CostStructure> mv;
+  const CancellationToken token = CancellationToken::Current();
+  Move mv;
+  CostStructure cost;
   explored = 0;
   while (explored < samples)
   {
-    RandomMove(st, mv.move);
-    mv.cost = DeltaCostFunctionComponents(st, mv.move, weights);
-    mv.is_valid = true;
+    if (explored > 0 && explored % batch_size == 0 && token.IsCancelled()) // polled as often as in the batched explorations
+      break;
+    RandomMove(st, mv);
     explored++;
-    if (AcceptMove(mv.move, mv.cost))
-      return mv;
+    BatchDeltaCostFunctionComponents(st, &mv, 1, &cost, weights);
+    if (AcceptMove(mv, cost))
+      return EvaluatedMove<Move, CostStructure>(mv, cost);
   }
   // exiting this loop means that there is no mv passing the acceptance criterion
   return EvaluatedMove<Move, CostStructure>::empty;
 }
 
 /**
-     This method will select the best move in the exhaustive neighborhood exploration that
+     This method will select the first move in the random neighborhood exploration that
+     matches with the criterion expressed by the functional object bool f(const Move& mv, CostStructure cost),
+     rejecting the moves which are proved to exceed the threshold drawn before their evaluation
+     @remarks moves are drawn and evaluated one at a time, since each of them is evaluated against its own threshold
+     */
+template <class Input, class State, class Move, class CostStructure>
+EvaluatedMove<Move, CostStructure> NeighborhoodExplorer<Input, State, Move, CostStructure>::RandomFirst(const State &st, size_t samples, size_t &explored, const ThresholdMoveAcceptor &AcceptMove, const MoveThreshold &Threshold, const std::vector<double> &weights) const
+{
+  const CancellationToken token = CancellationToken::Current();
+  Move mv;
+  CostStructure cost;
+  explored = 0;
+  while (explored < samples)
+  {
+    if (explored > 0 && explored % batch_size == 0 && token.IsCancelled()) // polled as often as in the batched explorations
+      break;
+    RandomMove(st, mv);
+    explored++;
+    double threshold = Threshold();
+    if (BoundedDeltaCostFunctionComponents(st, mv, threshold, cost, weights) && AcceptMove(mv, cost, threshold))
+      return EvaluatedMove<Move, CostStructure>(mv, cost);
+  }
+  // exiting this loop means that there is no mv passing the acceptance criterion
+  return EvaluatedMove<Move, CostStructure>::empty;
+}
+
+/**
+     This method will select the best move in the random neighborhood exploration that
      matches with the criterion expressed by the functional object bool f(const Move& mv, CostStructure cost)
      */
 template <class Input, class State, class Move, class CostStructure>
 EvaluatedMove<Move, CostStructure> NeighborhoodExplorer<Input, State, Move, CostStructure>::RandomBest(const State &st, size_t samples, size_t &explored, const MoveAcceptor &AcceptMove, const std::vector<double> &weights) const
 {
+  MoveBatch<Move, CostStructure> &batch = LocalBatch();
+  const CancellationToken token = CancellationToken::Current();
   unsigned int number_of_bests = 0; // number of moves found with the same best value
-  EvaluatedMove<Move, CostStructure> mv, best_move;
-
+  EvaluatedMove<Move, CostStructure> best_move;
   explored = 0;
+  batch.Reserve(std::min(samples, batch_size));
   while (explored < samples)
   {
-    RandomMove(st, mv.move);
-    mv.cost = DeltaCostFunctionComponents(st, mv.move, weights);
-    mv.is_valid = true;
-    explored++;
-    if (AcceptMove(mv.move, mv.cost))
+    size_t n = std::min(batch_size, samples - explored);
+    for (size_t i = 0; i < n; i++)
+      RandomMove(st, batch.moves[i]);
+    BatchDeltaCostFunctionComponents(st, batch.moves.data(), n, batch.costs.data(), weights);
+    explored += n;
+    for (size_t i = 0; i < n; i++)
     {
-      if (number_of_bests == 0)
+      if (AcceptMove(batch.moves[i], batch.costs[i]))
       {
-        best_move = mv;
-        number_of_bests = 1;
-      }
-      else if (mv.cost < best_move.cost)
-      {
-        best_move = mv;
-        number_of_bests = 1;
-      }
-      else if (mv.cost == best_move.cost)
-      {
-        if (Random::Uniform<unsigned int>(0, number_of_bests) == 0) // accept the move with probability 1 / (1 + number_of_bests)
-          best_move = mv;
-        number_of_bests++;
+        if (number_of_bests == 0)
+        {
+          best_move = EvaluatedMove<Move, CostStructure>(batch.moves[i], batch.costs[i]);
+          number_of_bests = 1;
+        }
+        else if (batch.costs[i] < best_move.cost)
+        {
+          best_move = EvaluatedMove<Move, CostStructure>(batch.moves[i], batch.costs[i]);
+          number_of_bests = 1;
+        }
+        else if (batch.costs[i] == best_move.cost)
+        {
+          if (Random::Uniform<unsigned int>(0, number_of_bests) == 0) // accept the move with probability 1 / (1 + number_of_bests)
+            best_move = EvaluatedMove<Move, CostStructure>(batch.moves[i], batch.costs[i]);
+          number_of_bests++;
+        }
       }
     }
+    if (token.IsCancelled())
+      break;
   }
 
   if (number_of_bests == 0)
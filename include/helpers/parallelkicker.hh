@@ -1,16 +1,14 @@
-#if defined(TBB_AVAILABLE)
-
 #pragma once
 
-#include "easylocal/helpers/kicker.hh"
-#include <iterator>
-#include <tbb/tbb.h>
+#include "helpers/kicker.hh"
+#include "utils/parallel.hh"
 
 namespace EasyLocal
 {
 namespace Core
 {
 
+/** A kicker which evaluates the kicks of the wrapped kicker @c K in parallel, by means of the algorithms of @ref Parallel (i.e., either TBB or the built-in thread pool). */
 template <class Input, class State, class K>
 class ParallelKicker : public K
 {
@@ -22,22 +20,15 @@ class ParallelKicker : public K
 public:
   virtual std::pair<Kick<State, MoveType, CostStructureType>, CostStructureType> SelectFirst(size_t length, const State &st) const
   {
-    tbb::spin_mutex mx_first_kick;
+    this->ne.ResolveComponentSlots(); // before evaluating moves concurrently
+    Parallel::SpinMutex mx_first_kick;
+    Parallel::Context context;
     Kick<State, MoveType, CostStructureType> first_kick;
     CostStructureType first_kick_cost;
     bool first_kick_found = false;
-    tbb::parallel_for_each(this->begin(length, st), this->end(length, st), [this, &mx_first_kick, &first_kick, &first_kick_cost, &first_kick_found](Kick<State, MoveType, CostStructureType> &k) {
-      CostStructureType cost(0, 0, 0, std::vector<CFtype>(this->sm.CostComponents(), 0));
-      for (int i = 0; i < k.size(); i++)
-      {
-        if (!k[i].first.is_valid)
-        {
-          k[i].first.cost = this->ne.DeltaCostFunctionComponents(k[i].second, k[i].first.move);
-          k[i].first.is_valid = true;
-        }
-        cost += k[i].first.cost;
-      }
-      tbb::spin_mutex::scoped_lock lock(mx_first_kick);
+    ForEachKick(length, st, [this, &mx_first_kick, &context, &first_kick, &first_kick_cost, &first_kick_found](Kick<State, MoveType, CostStructureType> &k) {
+      CostStructureType cost = EvaluateKick(k);
+      std::lock_guard<Parallel::SpinMutex> lock(mx_first_kick);
       if (!first_kick_found)
       {
         if (cost < 0)
@@ -45,33 +36,27 @@ public:
           first_kick_found = true;
           first_kick = k;
           first_kick_cost = cost;
-          tbb::task::self().cancel_group_execution();
+          context.Cancel();
         }
       }
-    });
+    },
+                context);
     if (!first_kick_found)
-      return std::make_pair(Kick<State, MoveType, CostStructureType>::empty, CostStructureType(std::numeric_limits<CFtype>::infinity(), std::numeric_limits<CFtype>::infinity(), std::numeric_limits<CFtype>::infinity(), std::vector<CFtype>(this->sm.CostComponents(), std::numeric_limits<CFtype>::infinity())));
+      return std::make_pair(Kick<State, MoveType, CostStructureType>::empty, CostStructureType(std::numeric_limits<CFtype>::infinity(), std::numeric_limits<CFtype>::infinity(), std::numeric_limits<CFtype>::infinity(), typename CostStructureType::ComponentsType(this->sm.CostComponents(), std::numeric_limits<CFtype>::infinity())));
     return std::make_pair(first_kick, first_kick_cost);
   }
 
   virtual std::pair<Kick<State, MoveType, CostStructureType>, CostStructureType> SelectBest(size_t length, const State &st) const
   {
-    tbb::spin_mutex mx_best_kick;
+    this->ne.ResolveComponentSlots(); // before evaluating moves concurrently
+    Parallel::SpinMutex mx_best_kick;
+    Parallel::Context context;
     Kick<State, MoveType, CostStructureType> best_kick;
     CostStructureType best_cost;
     unsigned int number_of_bests = 0;
-    tbb::parallel_for_each(this->begin(length, st), this->end(length, st), [this, &mx_best_kick, &best_kick, &best_cost, &number_of_bests](Kick<State, MoveType, CostStructureType> &k) {
-      CostStructureType cost(0, 0, 0, std::vector<CFtype>(this->sm.CostComponents(), 0));
-      for (int i = 0; i < k.size(); i++)
-      {
-        if (!k[i].first.is_valid)
-        {
-          k[i].first.cost = this->ne.DeltaCostFunctionComponents(k[i].second, k[i].first.move);
-          k[i].first.is_valid = true;
-        }
-        cost += k[i].first.cost;
-      }
-      tbb::spin_mutex::scoped_lock lock(mx_best_kick);
+    ForEachKick(length, st, [this, &mx_best_kick, &best_kick, &best_cost, &number_of_bests](Kick<State, MoveType, CostStructureType> &k) {
+      CostStructureType cost = EvaluateKick(k);
+      std::lock_guard<Parallel::SpinMutex> lock(mx_best_kick);
       if (number_of_bests == 0)
       {
         best_kick = k;
@@ -90,32 +75,69 @@ public:
           best_kick = k;
         number_of_bests++;
       }
-    });
+    },
+                context);
     return std::make_pair(best_kick, best_cost);
   }
 
-  virtual std::pair<Kick<State, MoveType, CostStructureType>, CostStructureType> SelectRandom(size_t length, const State &st) const throw(EmptyNeighborhood)
+  virtual std::pair<Kick<State, MoveType, CostStructureType>, CostStructureType> SelectRandom(size_t length, const State &st) const
   {
+    this->ne.ResolveComponentSlots(); // before evaluating moves concurrently
+    Parallel::Context context;
     Kick<State, MoveType, CostStructureType> k = *this->sample_begin(length, st, 1);
-    CostStructureType zero(0, 0, 0, std::vector<CFtype>(this->sm.CostComponents(), 0));
-    CostStructureType cost = tbb::parallel_reduce(tbb::blocked_range<typename Kick<State, MoveType, CostStructureType>::iterator>(k.begin(), k.end()), zero,
-                                                  [this](const tbb::blocked_range<typename Kick<State, MoveType, CostStructureType>::iterator> &r, CostStructureType init) -> CostStructureType {
-                                                    for (typename Kick<State, MoveType, CostStructureType>::iterator it = r.begin(); it != r.end(); ++it)
-                                                    {
-                                                      it->first.cost = this->ne.DeltaCostFunctionComponents(it->second, it->first.move);
-                                                      it->first.is_valid = true;
-                                                      init += it->first.cost;
-                                                    }
-                                                    return init;
-                                                  },
-                                                  [](const CostStructureType &a, const CostStructureType &b) -> CostStructureType {
-                                                    return CostStructureType(a + b);
-                                                  });
+    CostStructureType zero(0, 0, 0, typename CostStructureType::ComponentsType(this->sm.CostComponents(), 0));
+    CostStructureType cost = Parallel::Reduce(0, k.size(), 1, zero, [this, &k](size_t first, size_t last, CostStructureType init) -> CostStructureType {
+      for (size_t i = first; i < last; i++)
+      {
+        k[i].first.cost = this->ne.DeltaCostFunctionComponents(k[i].second, k[i].first.move);
+        k[i].first.is_valid = true;
+        init += k[i].first.cost;
+      }
+      return init;
+    },
+                                              [](const CostStructureType &a, const CostStructureType &b) -> CostStructureType {
+                                                return CostStructureType(a + b);
+                                              },
+                                              context);
 
     return std::make_pair(k, cost);
   }
+
+protected:
+  /** Runs a body in parallel over the kicks of the given length, which are generated serially until the @ref CancellationToken of the calling thread is cancelled (after the first kick). */
+  template <class Body>
+  void ForEachKick(size_t length, const State &st, const Body &body, Parallel::Context &context) const
+  {
+    typedef decltype(this->begin(length, st)) Iterator;
+    Iterator it = this->begin(length, st), last = this->end(length, st);
+    const CancellationToken token = CancellationToken::Current(); // the kicks may be generated by a worker
+    bool started = false;
+    Parallel::Pipeline<Kick<State, MoveType, CostStructureType>>(4 * Parallel::MaxConcurrency(), [&it, &last, &token, &started](Kick<State, MoveType, CostStructureType> &k) {
+      if (it == last || (started && token.IsCancelled()))
+        return false;
+      started = true;
+      k = *it;
+      ++it;
+      return true;
+    },
+                                                                 body, context);
+  }
+
+  /** Computes the cost of a kick, evaluating the moves not evaluated yet. */
+  CostStructureType EvaluateKick(Kick<State, MoveType, CostStructureType> &k) const
+  {
+    CostStructureType cost(0, 0, 0, typename CostStructureType::ComponentsType(this->sm.CostComponents(), 0));
+    for (size_t i = 0; i < k.size(); i++)
+    {
+      if (!k[i].first.is_valid)
+      {
+        k[i].first.cost = this->ne.DeltaCostFunctionComponents(k[i].second, k[i].first.move);
+        k[i].first.is_valid = true;
+      }
+      cost += k[i].first.cost;
+    }
+    return cost;
+  }
 };
 } // namespace Core
 } // namespace EasyLocal
-
-#endif
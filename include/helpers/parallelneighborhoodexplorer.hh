@@ -1,10 +1,10 @@
-#if defined(TBB_AVAILABLE)
-
 #pragma once
 
 #include "neighborhoodexplorer.hh"
+#include "utils/parallel.hh"
+#include <atomic>
 #include <iterator>
-#include <tbb/tbb.h>
+#include <random>
 
 namespace EasyLocal
 {
@@ -14,8 +14,9 @@ namespace Core
 template <class Input, class State, class Move, class CostStructure = DefaultCostStructure<int>>
 class NeighborhoodExplorerIteratorInterface;
 
+/** An input iterator over the whole neighborhood of a state, which yields batches of (at most @c batch_size) consecutive moves. */
 template <class Input, class State, class Move, class CostStructure>
-class FullNeighborhoodIterator : public std::iterator<std::input_iterator_tag, EvaluatedMove<Move, CostStructure>>
+class FullNeighborhoodIterator : public std::iterator<std::input_iterator_tag, std::vector<Move>>
 {
   friend class NeighborhoodExplorerIteratorInterface<Input, State, Move, CostStructure>;
 
@@ -23,248 +24,173 @@ public:
   FullNeighborhoodIterator operator++(int) // postfix
   {
     FullNeighborhoodIterator pi = *this;
-    if (end)
-      throw std::logic_error("Attempting to go after last move");
-    end = !ne.NextMove(state, current_move);
-    move_count++;
-    computed_move = EvaluatedMove<Move, CostStructure>(current_move);
+    ++(*this);
     return pi;
   }
   FullNeighborhoodIterator &operator++() // prefix
   {
     if (end)
       throw std::logic_error("Attempting to go after last move");
-    end = !ne.NextMove(state, current_move);
-    move_count++;
-    computed_move = EvaluatedMove<Move, CostStructure>(current_move);
+    end = last_move;
+    if (!end)
+      FillBatch();
+    batch_count++;
     return *this;
   }
-  EvaluatedMove<Move, CostStructure> operator*() const
+  const std::vector<Move> &operator*() const
   {
-    return computed_move;
+    return batch;
   }
-  EvaluatedMove<Move, CostStructure> *operator->() const
+  const std::vector<Move> *operator->() const
   {
-    return &computed_move;
+    return &batch;
   }
   bool operator==(const FullNeighborhoodIterator<Input, State, Move, CostStructure> &it2) const
   {
     if (end && it2.end)
       return true;
-    return (end == it2.end && move_count == it2.move_count && &state == &it2.state);
+    return (end == it2.end && batch_count == it2.batch_count && &state == &it2.state);
   }
-  bool operator!=(const FullNeighborhoodIterator<Input, State, Move, CostStructure> &it2)
+  bool operator!=(const FullNeighborhoodIterator<Input, State, Move, CostStructure> &it2) const
   {
-    if (end && it2.end)
-      return false;
-    return (end != it2.end || move_count != it2.move_count || &state != &it2.state);
+    return !(*this == it2);
   }
 
 protected:
-  FullNeighborhoodIterator(const NeighborhoodExplorer<Input, State, Move, CostStructure> &ne, const State &state, bool end = false)
-      : ne(ne), state(state), move_count(0), end(end)
+  FullNeighborhoodIterator(const NeighborhoodExplorer<Input, State, Move, CostStructure> &ne, const State &state, size_t batch_size, bool end = false)
+      : ne(ne), state(state), batch_size(batch_size), batch_count(0), last_move(false), end(end)
   {
     if (end)
       return;
     try
     {
       ne.FirstMove(state, current_move);
-      computed_move = EvaluatedMove<Move, CostStructure>(current_move);
+      FillBatch();
     }
-    catch (EmptyNeighborhood)
+    catch (EmptyNeighborhood &)
     {
-      end = true;
+      this->end = true;
     }
   }
+  void FillBatch()
+  {
+    batch.clear();
+    do
+    {
+      batch.push_back(current_move);
+      last_move = !ne.NextMove(state, current_move);
+    } while (!last_move && batch.size() < batch_size);
+  }
   const NeighborhoodExplorer<Input, State, Move, CostStructure> &ne;
   const State &state;
   Move current_move;
-  EvaluatedMove<Move, CostStructure> computed_move;
-  size_t move_count;
-  bool end;
+  std::vector<Move> batch;
+  size_t batch_size, batch_count;
+  bool last_move, end;
 };
-  
-  template <class Input, class State, class Move, class CostStructure>
-  class StartingNeighborhoodIterator : public std::iterator<std::input_iterator_tag, EvaluatedMove<Move, CostStructure>>
-  {
-    friend class NeighborhoodExplorerIteratorInterface<Input, State, Move, CostStructure>;
-    
-  public:
-    StartingNeighborhoodIterator operator++(int) // postfix
-    {
-      StartingNeighborhoodIterator pi = *this;
-      if (end)
-        throw std::logic_error("Attempting to go after last move");
-      if (!ne.NextMove(state, current_move))
-      {
-        ne.FirstMove(state, current_move);
-        rounds++;
-      }
-      end = (current_move == start_move) || rounds > 1;
-      move_count++;
-      computed_move = EvaluatedMove<Move, CostStructure>(current_move);
-      return pi;
-    }
-    StartingNeighborhoodIterator &operator++() // prefix
-    {
-      if (end)
-        throw std::logic_error("Attempting to go after last move");
-      if (!ne.NextMove(state, current_move))
-      {
-        ne.FirstMove(state, current_move);
-        rounds++;
-      }
-      end = (current_move == start_move) || rounds > 1;
-      move_count++;
-      computed_move = EvaluatedMove<Move, CostStructure>(current_move);
-      return *this;
-    }
-    EvaluatedMove<Move, CostStructure> operator*() const
-    {
-      return computed_move;
-    }
-    EvaluatedMove<Move, CostStructure> *operator->() const
-    {
-      return &computed_move;
-    }
-    bool operator==(const StartingNeighborhoodIterator<Input, State, Move, CostStructure> &it2) const
-    {
-      if (end && it2.end)
-        return true;
-      return (end == it2.end && move_count == it2.move_count && &state == &it2.state && start_move == it2.start_move);
-    }
-    bool operator!=(const StartingNeighborhoodIterator<Input, State, Move, CostStructure> &it2)
-    {
-      if (end && it2.end)
-        return false;
-      return (end != it2.end || move_count != it2.move_count || &state != &it2.state || start_move != it2.start_move);
-    }
-    
-  protected:
-    StartingNeighborhoodIterator(const NeighborhoodExplorer<Input, State, Move, CostStructure> &ne, const Move& start_move, const State &state, bool end = false)
-    : ne(ne), state(state), start_move(start_move), rounds(0), move_count(0), end(end)
-    {
-      if (end)
-        return;
-      try
-      {
-        ne.FirstMove(state, current_move);
-        current_move = start_move;
-        computed_move = EvaluatedMove<Move, CostStructure>(current_move);
-      }
-      catch (EmptyNeighborhood)
-      {
-        end = true;
-      }
-    }
-    const NeighborhoodExplorer<Input, State, Move, CostStructure> &ne;
-    const State &state;
-    const Move& start_move;
-    unsigned int rounds;
-    Move current_move;
-    EvaluatedMove<Move, CostStructure> computed_move;
-    size_t move_count;
-    bool end;
-  };
 
+/** An input iterator over the whole neighborhood of a state, starting after a given move and wrapping around the end of the neighborhood, which yields batches of (at most @c batch_size) consecutive moves. */
 template <class Input, class State, class Move, class CostStructure>
-class SampleNeighborhoodIterator : public std::iterator<std::input_iterator_tag, EvaluatedMove<Move, CostStructure>>
+class StartingNeighborhoodIterator : public std::iterator<std::input_iterator_tag, std::vector<Move>>
 {
   friend class NeighborhoodExplorerIteratorInterface<Input, State, Move, CostStructure>;
 
 public:
-  SampleNeighborhoodIterator operator++(int) // postfix
+  StartingNeighborhoodIterator operator++(int) // postfix
   {
-    SampleNeighborhoodIterator pi = *this;
-    if (end)
-      throw std::logic_error("Attempting to go after last move");
-    move_count++;
-    end = move_count >= samples;
-    if (!end)
-    {
-      ne.RandomMove(state, current_move);
-      computed_move = EvaluatedMove<Move, CostStructure>(current_move, 0);
-    }
+    StartingNeighborhoodIterator pi = *this;
+    ++(*this);
     return pi;
   }
-  SampleNeighborhoodIterator &operator++() // prefix
+  StartingNeighborhoodIterator &operator++() // prefix
   {
     if (end)
       throw std::logic_error("Attempting to go after last move");
-    move_count++;
-    end = move_count >= samples;
+    end = last_move;
     if (!end)
     {
-      ne.RandomMove(state, current_move);
-      computed_move = EvaluatedMove<Move, CostStructure>(current_move);
+      FillBatch();
+      end = batch.empty();
     }
+    batch_count++;
     return *this;
   }
-  EvaluatedMove<Move, CostStructure> operator*() const
+  const std::vector<Move> &operator*() const
   {
-    return computed_move;
+    return batch;
   }
-  const EvaluatedMove<Move, CostStructure> *operator->() const
+  const std::vector<Move> *operator->() const
   {
-    return &computed_move;
+    return &batch;
   }
-  bool operator==(const SampleNeighborhoodIterator<Input, State, Move, CostStructure> &it2) const
+  bool operator==(const StartingNeighborhoodIterator<Input, State, Move, CostStructure> &it2) const
   {
     if (end && it2.end)
       return true;
-    return (end == it2.end && move_count == it2.move_count && &state == &it2.state);
+    return (end == it2.end && batch_count == it2.batch_count && &state == &it2.state && start_move == it2.start_move);
   }
-  bool operator!=(const SampleNeighborhoodIterator<Input, State, Move, CostStructure> &it2)
+  bool operator!=(const StartingNeighborhoodIterator<Input, State, Move, CostStructure> &it2) const
   {
-    if (end && it2.end)
-      return false;
-    return (end != it2.end || move_count != it2.move_count || &state != &it2.state);
+    return !(*this == it2);
   }
 
 protected:
-  SampleNeighborhoodIterator(const NeighborhoodExplorer<Input, State, Move, CostStructure> &ne, const State &state, size_t samples, bool end = false)
-      : ne(ne), state(state), move_count(0), samples(samples), end(end)
+  StartingNeighborhoodIterator(const NeighborhoodExplorer<Input, State, Move, CostStructure> &ne, const Move &start_move, const State &state, size_t batch_size, bool end = false)
+      : ne(ne), state(state), start_move(start_move), current_move(start_move), rounds(0), batch_size(batch_size), batch_count(0), last_move(false), end(end)
   {
     if (end)
       return;
-    try
-    {
-      ne.RandomMove(state, current_move);
-    }
-    catch (EmptyNeighborhood)
+    FillBatch();
+    this->end = batch.empty();
+  }
+  /** Fills the batch following the same enumeration as the sequential @ref NeighborhoodExplorer::SelectFirst, i.e., from the move after @c start_move up to @c start_move itself. */
+  void FillBatch()
+  {
+    batch.clear();
+    do
     {
-      end = true;
-    }
-    computed_move = EvaluatedMove<Move, CostStructure>(current_move);
+      if (!ne.NextMove(state, current_move))
+      {
+        if (rounds > 0) // start_move is not in the neighborhood, stop after a full round
+        {
+          last_move = true;
+          break;
+        }
+        ne.FirstMove(state, current_move);
+        rounds++;
+      }
+      batch.push_back(current_move);
+      last_move = (current_move == start_move);
+    } while (!last_move && batch.size() < batch_size);
   }
   const NeighborhoodExplorer<Input, State, Move, CostStructure> &ne;
   const State &state;
+  const Move start_move;
   Move current_move;
-  EvaluatedMove<Move, CostStructure> computed_move;
-  size_t move_count, samples;
-  bool end;
+  unsigned int rounds;
+  std::vector<Move> batch;
+  size_t batch_size, batch_count;
+  bool last_move, end;
 };
 
 template <class Input, class State, class Move, class CostStructure>
 class NeighborhoodExplorerIteratorInterface
 {
 protected:
-  static FullNeighborhoodIterator<Input, State, Move, CostStructure> create_full_neighborhood_iterator(const NeighborhoodExplorer<Input, State, Move, CostStructure> &ne, const State &st, bool end = false)
-  {
-    return FullNeighborhoodIterator<Input, State, Move, CostStructure>(ne, st, end);
-  }
-  
-  static StartingNeighborhoodIterator<Input, State, Move, CostStructure> create_starting_neighborhood_iterator(const NeighborhoodExplorer<Input, State, Move, CostStructure> &ne, const Move& start_move, const State &st, bool end = false)
+  static FullNeighborhoodIterator<Input, State, Move, CostStructure> create_full_neighborhood_iterator(const NeighborhoodExplorer<Input, State, Move, CostStructure> &ne, const State &st, size_t batch_size, bool end = false)
   {
-    return StartingNeighborhoodIterator<Input, State, Move, CostStructure>(ne, start_move, st, end);
+    return FullNeighborhoodIterator<Input, State, Move, CostStructure>(ne, st, batch_size, end);
   }
 
-  static SampleNeighborhoodIterator<Input, State, Move, CostStructure> create_sample_neighborhood_iterator(const NeighborhoodExplorer<Input, State, Move, CostStructure> &ne, const State &st, size_t samples, bool end = false)
+  static StartingNeighborhoodIterator<Input, State, Move, CostStructure> create_starting_neighborhood_iterator(const NeighborhoodExplorer<Input, State, Move, CostStructure> &ne, const Move &start_move, const State &st, size_t batch_size, bool end = false)
   {
-    return SampleNeighborhoodIterator<Input, State, Move, CostStructure>(ne, st, samples, end);
+    return StartingNeighborhoodIterator<Input, State, Move, CostStructure>(ne, start_move, st, batch_size, end);
   }
 };
 
+/** A neighborhood explorer which evaluates the batches of moves of the wrapped explorer @c NE in parallel, by means of the algorithms of @ref Parallel (i.e., either TBB or the built-in thread pool).
+     @ingroup Helpers
+     */
 template <class Input, class State, class NE>
 class ParallelNeighborhoodExplorer : public NE, public NeighborhoodExplorerIteratorInterface<Input, State, typename NE::MoveType, typename NE::CostStructureType>
 {
@@ -273,191 +199,415 @@ public:
   using typename NE::CFtype;
   using typename NE::CostStructureType;
   using typename NE::MoveAcceptor;
+  using typename NE::MoveThreshold;
+  using typename NE::ThresholdMoveAcceptor;
   using typename NE::MoveType;
 
 protected:
+  typedef NeighborhoodExplorerIteratorInterface<Input, State, MoveType, CostStructureType> IteratorInterface;
+
   FullNeighborhoodIterator<Input, State, MoveType, CostStructureType> begin(const State &st) const
   {
-    return NeighborhoodExplorerIteratorInterface<Input, State, MoveType, CostStructureType>::create_full_neighborhood_iterator(*this, st);
+    return IteratorInterface::create_full_neighborhood_iterator(*this, st, this->batch_size);
   }
 
   FullNeighborhoodIterator<Input, State, MoveType, CostStructureType> end(const State &st) const
   {
-    return NeighborhoodExplorerIteratorInterface<Input, State, MoveType, CostStructureType>::create_full_neighborhood_iterator(*this, st, true);
+    return IteratorInterface::create_full_neighborhood_iterator(*this, st, this->batch_size, true);
   }
-  
-  StartingNeighborhoodIterator<Input, State, MoveType, CostStructureType> begin(const MoveType& start_move, const State &st) const
+
+  StartingNeighborhoodIterator<Input, State, MoveType, CostStructureType> begin(const MoveType &start_move, const State &st) const
   {
-    return NeighborhoodExplorerIteratorInterface<Input, State, MoveType, CostStructureType>::create_starting_neighborhood_iterator(*this, start_move, st);
+    return IteratorInterface::create_starting_neighborhood_iterator(*this, start_move, st, this->batch_size);
   }
-  
-  StartingNeighborhoodIterator<Input, State, MoveType, CostStructureType> end(const MoveType& start_move, const State &st) const
+
+  StartingNeighborhoodIterator<Input, State, MoveType, CostStructureType> end(const MoveType &start_move, const State &st) const
   {
-    return NeighborhoodExplorerIteratorInterface<Input, State, MoveType, CostStructureType>::create_starting_neighborhood_iterator(*this, start_move, st, true);
+    return IteratorInterface::create_starting_neighborhood_iterator(*this, start_move, st, this->batch_size, true);
   }
 
-  SampleNeighborhoodIterator<Input, State, MoveType, CostStructureType> sample_begin(const State &st, size_t samples) const
+  /** Returns a scheduler which runs a body in parallel over the batches produced by the iterators. The batches are generated serially and handed over to the threads evaluating them by means of a pipeline, which bounds the number of batches in flight.
+       A scheduler passes to the body each batch together with the position of its first move in the exploration order, and it stops generating batches once they start at or after the horizon. */
+  template <class Iterator>
+  static auto IteratorBatches(Iterator first, Iterator last)
   {
-    if (samples > 0)
-      return NeighborhoodExplorerIteratorInterface<Input, State, MoveType, CostStructureType>::create_sample_neighborhood_iterator(*this, st, samples);
-    else
-      return sample_end(st, samples);
+    typedef std::pair<size_t, std::vector<MoveType>> IndexedBatch;
+    return [first, last](const auto &body, Parallel::Context &context, const std::atomic<size_t> &horizon) {
+      Iterator it = first;
+      size_t index = 0;
+      Parallel::Pipeline<IndexedBatch>(4 * Parallel::MaxConcurrency(), [&it, &last, &index, &horizon](IndexedBatch &batch) {
+        if (it == last || index >= horizon.load(std::memory_order_relaxed))
+          return false;
+        batch = IndexedBatch(index, *it);
+        index += batch.second.size();
+        ++it;
+        return true;
+      },
+                                       [&body](const IndexedBatch &batch) { body(batch.second, batch.first); }, context);
+    };
   }
 
-  SampleNeighborhoodIterator<Input, State, MoveType, CostStructureType> sample_end(const State &st, size_t samples) const
+  /** Returns a scheduler which runs a body in parallel over the batches of moves obtained by splitting the range of indices of the neighborhood (see @ref NeighborhoodExplorer::MoveAt), each batch being generated by the thread evaluating it. */
+  auto IndexedBatches(const State &st) const
   {
-    return NeighborhoodExplorerIteratorInterface<Input, State, MoveType, CostStructureType>::create_sample_neighborhood_iterator(*this, st, samples, true);
+    return [this, &st](const auto &body, Parallel::Context &context, const std::atomic<size_t> &horizon) {
+      Parallel::For(0, this->NeighborhoodSize(st), this->batch_size, [this, &st, &body, &horizon](size_t first, size_t last) {
+        if (first >= horizon.load(std::memory_order_relaxed))
+          return;
+        std::vector<MoveType> moves(last - first);
+        for (size_t i = 0; i < moves.size(); i++)
+          this->MoveAt(st, first + i, moves[i]);
+        body(moves, first);
+      },
+                    context);
+    };
   }
 
-public:
-  virtual EvaluatedMove<MoveType, CostStructureType> SelectFirst(const State &st, size_t &explored, const MoveAcceptor &AcceptMove, const std::vector<double> &weights = std::vector<double>(0)) const throw(EmptyNeighborhood)
+  /** Returns a scheduler which runs a body in parallel over the batches of moves of an indexed neighborhood (see @ref NeighborhoodExplorer::MoveAt), which are claimed by the threads in increasing order of their positions. Unlike @ref IndexedBatches, the batches are therefore evaluated (speculatively) in the exploration order, which suits first-improvement explorations. */
+  auto OrderedIndexedBatches(const State &st) const
   {
-    EvaluatedMove<MoveType, CostStructureType> first_move;
-    bool first_move_found = false;
-    tbb::spin_mutex mx_first_move;
-    explored = 0;
-    tbb::parallel_for_each(this->begin(st), this->end(st), [this, &st, &mx_first_move, &first_move, &first_move_found, AcceptMove, &weights, &explored](EvaluatedMove<MoveType, CostStructureType> &mv) {
-      mv.cost = this->DeltaCostFunctionComponents(st, mv.move, weights);
-      mv.is_valid = true;
-      tbb::spin_mutex::scoped_lock lock(mx_first_move);
-      explored++;
-      if (!first_move_found)
-      {
-        if (AcceptMove(mv.move, mv.cost))
+    return [this, &st](const auto &body, Parallel::Context &context, const std::atomic<size_t> &horizon) {
+      const size_t size = this->NeighborhoodSize(st), batch_size = this->batch_size;
+      std::atomic<size_t> next_batch(0);
+      Parallel::For(0, Parallel::MaxConcurrency(), 1, [this, &st, &body, &context, &horizon, &next_batch, size, batch_size](size_t, size_t) {
+        std::vector<MoveType> moves;
+        for (size_t first = next_batch++ * batch_size; first < size && first < horizon.load(std::memory_order_relaxed) && !context.IsCancelled(); first = next_batch++ * batch_size)
         {
-          first_move_found = true;
-          first_move = mv;
-          tbb::task::self().cancel_group_execution();
+          moves.resize(std::min(batch_size, size - first));
+          for (size_t i = 0; i < moves.size(); i++)
+            this->MoveAt(st, first + i, moves[i]);
+          body(moves, first);
         }
-      }
-    });
-    if (!first_move_found)
-      return EvaluatedMove<MoveType, CostStructureType>::empty;
-    return first_move;
+      },
+                    context);
+    };
   }
-  
-  virtual EvaluatedMove<MoveType, CostStructureType> SelectFirst(const MoveType& start_move, const State &st, size_t &explored, const MoveAcceptor &AcceptMove, const std::vector<double> &weights = std::vector<double>(0)) const throw(EmptyNeighborhood)
+
+  /** Returns a scheduler which runs a body in parallel over the batches of a random sample of the neighborhood. The sample is split in shares, and each share is generated (in batches) and evaluated by a single task, drawing the moves from a random stream of its own. The streams are derived from a seed drawn by the calling thread, so that, for a given number of shares, the sample does not depend on the scheduling. There are as many shares as the threads, or a fixed number of them in deterministic mode (see @ref SetDeterministic). */
+  auto SampledBatches(const State &st, size_t samples) const
   {
-    EvaluatedMove<MoveType, CostStructureType> first_move;
-    bool first_move_found = false;
-    tbb::spin_mutex mx_first_move;
-    explored = 0;
-    tbb::parallel_for_each(this->begin(start_move, st), this->end(start_move, st), [this, &st, &mx_first_move, &first_move, &first_move_found, AcceptMove, &weights, &explored](EvaluatedMove<MoveType, CostStructureType> &mv) {
-      mv.cost = this->DeltaCostFunctionComponents(st, mv.move, weights);
-      mv.is_valid = true;
-      tbb::spin_mutex::scoped_lock lock(mx_first_move);
-      explored++;
-      if (!first_move_found)
+    unsigned int seed = Random::Uniform<unsigned int>(0, std::numeric_limits<unsigned int>::max());
+    return [this, &st, samples, seed](const auto &body, Parallel::Context &context, const std::atomic<size_t> &horizon) {
+      const size_t batch_size = this->batch_size, batches = (samples + batch_size - 1) / batch_size;
+      const size_t shares = std::min(batches, deterministic ? deterministic_shares : Parallel::MaxConcurrency());
+      try
       {
-        if (AcceptMove(mv.move, mv.cost))
-        {
-          first_move_found = true;
-          first_move = mv;
-          tbb::task::self().cancel_group_execution();
-        }
+        Parallel::For(0, shares, 1, [this, &st, &body, &context, &horizon, samples, seed, batch_size, batches, shares](size_t first_share, size_t last_share) {
+          for (size_t share = first_share; share != last_share; ++share)
+          {
+            Random::Engine g;
+            g.seed(seed + static_cast<unsigned int>(share));
+            Random::ScopedStream stream(g);
+            std::vector<MoveType> moves;
+            for (size_t b = share * batches / shares; b < (share + 1) * batches / shares && b * batch_size < horizon.load(std::memory_order_relaxed) && !context.IsCancelled(); b++)
+            {
+              moves.resize(std::min(batch_size, samples - b * batch_size));
+              for (MoveType &mv : moves)
+                this->RandomMove(st, mv);
+              body(moves, b * batch_size);
+            }
+          }
+        },
+                      context);
       }
-    });
-    if (!first_move_found)
-      return EvaluatedMove<MoveType, CostStructureType>::empty;
-    return first_move;
+      catch (EmptyNeighborhood &)
+      {
+        // no move can be sampled
+      }
+    };
   }
 
-  virtual EvaluatedMove<MoveType, CostStructureType> SelectBest(const State &st, size_t &explored, const MoveAcceptor &AcceptMove, const std::vector<double> &weights = std::vector<double>(0)) const throw(EmptyNeighborhood)
+  /** Returns a pseudo-random key of a move, depending only on the seed and on the position of the move in the exploration order, which is used to break ties deterministically. */
+  static uint64_t MoveKey(uint64_t seed, size_t index)
   {
-    tbb::spin_mutex mx_best_move;
-    EvaluatedMove<MoveType, CostStructureType> best_move;
-    unsigned int number_of_bests = 0;
-    explored = 0;
-    tbb::parallel_for_each(this->begin(st), this->end(st), [this, &st, &mx_best_move, &best_move, &number_of_bests, AcceptMove, &weights, &explored](EvaluatedMove<MoveType, CostStructureType> &mv) {
-      mv.cost = this->DeltaCostFunctionComponents(st, mv.move, weights);
-      mv.is_valid = true;
-      tbb::spin_mutex::scoped_lock lock(mx_best_move);
-      explored++;
-      if (AcceptMove(mv.move, mv.cost))
+    uint64_t z = seed + (index + 1) * 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  /** The best accepted move among the ones evaluated by a thread, together with the number of (equivalent) best moves it has been drawn from, so that partial results can be merged preserving the uniform choice among ties. In deterministic mode, ties are broken in favour of the move with the lowest key (see @ref MoveKey) instead. */
+  struct BestMoveAccumulator
+  {
+    BestMoveAccumulator(unsigned long seed, unsigned long stream, bool deterministic) : number_of_bests(0), explored(0), key(0), seed(seed), deterministic(deterministic)
+    {
+      std::seed_seq seq{seed, stream};
+      g.seed(seq);
+    }
+    void Add(const MoveType &mv, const CostStructureType &cost, size_t index)
+    {
+      uint64_t move_key = deterministic ? MoveKey(seed, index) : 0;
+      if (number_of_bests == 0 || cost < best_move.cost)
       {
-        if (number_of_bests == 0)
-        {
-          best_move = mv;
-          number_of_bests = 1;
-        }
-        else if (mv.cost < best_move.cost)
+        best_move = EvaluatedMove<MoveType, CostStructureType>(mv, cost);
+        number_of_bests = 1;
+        key = move_key;
+      }
+      else if (cost == best_move.cost)
+      {
+        if (deterministic ? move_key < key : std::uniform_int_distribution<unsigned long>(0, number_of_bests)(g) == 0) // accept the move with probability 1 / (1 + number_of_bests)
         {
-          best_move = mv;
-          number_of_bests = 1;
+          best_move = EvaluatedMove<MoveType, CostStructureType>(mv, cost);
+          key = move_key;
         }
-        else if (mv.cost == best_move.cost)
+        number_of_bests++;
+      }
+    }
+    void Merge(const BestMoveAccumulator &other)
+    {
+      explored += other.explored;
+      if (other.number_of_bests == 0)
+        return;
+      if (number_of_bests == 0 || other.best_move.cost < best_move.cost)
+      {
+        best_move = other.best_move;
+        number_of_bests = other.number_of_bests;
+        key = other.key;
+      }
+      else if (other.best_move.cost == best_move.cost)
+      {
+        // the move of the other accumulator is drawn with probability proportional to the number of moves it represents
+        if (deterministic ? other.key < key : std::uniform_int_distribution<unsigned long>(0, number_of_bests + other.number_of_bests - 1)(g) < other.number_of_bests)
         {
-          if (Random::Uniform<unsigned int>(0, number_of_bests) == 0) // accept the move with probability 1 / (1 + number_of_bests)
-            best_move = mv;
-          number_of_bests++;
+          best_move = other.best_move;
+          key = other.key;
         }
+        number_of_bests += other.number_of_bests;
       }
-    });
-    if (number_of_bests == 0)
-      return EvaluatedMove<MoveType, CostStructureType>::empty;
-    return best_move;
+    }
+    EvaluatedMove<MoveType, CostStructureType> best_move;
+    unsigned long number_of_bests;
+    size_t explored;
+    uint64_t key, seed;
+    bool deterministic;
+    std::minstd_rand g;
+  };
+
+  /** The accepted move with the lowest position in the exploration order among the ones found by a thread. */
+  struct FirstMoveCandidate
+  {
+    FirstMoveCandidate() : index(std::numeric_limits<size_t>::max()), explored(0) {}
+    size_t index;
+    /** The moves evaluated in the batches up to the one of the move (included) */
+    size_t explored;
+    EvaluatedMove<MoveType, CostStructureType> first_move;
+  };
+
+  /** Evaluates the batches produced by the scheduler in parallel and returns the first accepted move, i.e., the first one claimed by a thread or, in ordered (or deterministic) mode, the one with the lowest position in the exploration order. The acceptance criterion is evaluated concurrently, outside of any lock.
+       As in the serial explorer, @c explored is the number of moves actually evaluated, including the ones following the accepted move in its batch and the ones of the batches evaluated concurrently. In deterministic mode, however, the batches following the one of the accepted move are not counted, since which of them are evaluated depends on the scheduling. */
+  template <class Scheduler>
+  EvaluatedMove<MoveType, CostStructureType> ParallelFirst(const Scheduler &for_each_batch, const State &st, size_t &explored, const MoveAcceptor &AcceptMove, const std::vector<double> &weights) const
+  {
+    return ParallelFirst(for_each_batch, explored, [this, &st, &weights](const std::vector<MoveType> &moves, std::vector<CostStructureType> &costs) {
+      this->BatchDeltaCostFunctionComponents(st, moves.data(), moves.size(), costs.data(), weights);
+    },
+                         [&AcceptMove](const MoveType &mv, CostStructureType &cost) { return AcceptMove(mv, cost); }, true);
   }
 
-  virtual EvaluatedMove<MoveType, CostStructureType> RandomFirst(const State &st, size_t samples, size_t &explored, const MoveAcceptor &AcceptMove, const std::vector<double> &weights = std::vector<double>(0)) const throw(EmptyNeighborhood)
+  /** Finds the first accepted move as above, where each batch is prepared by @c EvaluateBatch (e.g., computing the costs of its moves) and then each move is tested in order by @c Accept, which might complete the evaluation of the move in its cost.
+       @param batch_evaluated whether @c EvaluateBatch evaluates all the moves of the batch, otherwise only the moves tested by @c Accept are evaluated (and counted)
+       */
+  template <class Scheduler, class BatchEvaluator, class Acceptor>
+  EvaluatedMove<MoveType, CostStructureType> ParallelFirst(const Scheduler &for_each_batch, size_t &explored, const BatchEvaluator &EvaluateBatch, const Acceptor &Accept, bool batch_evaluated) const
   {
+    if (!this->slots_resolved)
+      this->ResolveComponentSlots(); // before evaluating moves concurrently
+    Parallel::Context context;
+    const CancellationToken token = CancellationToken::Current(); // the workers do not see the token of the calling thread
+    std::atomic<size_t> horizon(std::numeric_limits<size_t>::max()), explored_moves(0);
+    if (deterministic || ordered_first)
+    {
+      // batches starting after an accepted move are skipped, but the ones before it have to be completed
+      Parallel::ThreadSpecific<FirstMoveCandidate> candidates;
+      for_each_batch([&candidates, &EvaluateBatch, &Accept, &explored_moves, &horizon, &context, &token, batch_evaluated](const std::vector<MoveType> &moves, size_t first_index) {
+        if (first_index >= horizon.load(std::memory_order_relaxed))
+          return;
+        std::vector<CostStructureType> costs(moves.size());
+        EvaluateBatch(moves, costs);
+        size_t i = 0;
+        for (; i < moves.size() && first_index + i < horizon.load(std::memory_order_relaxed); i++)
+          if (Accept(moves[i], costs[i]))
+          {
+            FirstMoveCandidate &candidate = candidates.Local();
+            if (first_index + i < candidate.index)
+            {
+              candidate.index = first_index + i;
+              // the batches preceding this one have been evaluated as a whole, since they have no accepted move
+              candidate.explored = first_index + (batch_evaluated ? moves.size() : i + 1);
+              candidate.first_move = EvaluatedMove<MoveType, CostStructureType>(moves[i], costs[i]);
+            }
+            size_t current = horizon.load();
+            while (first_index + i < current && !horizon.compare_exchange_weak(current, first_index + i))
+              ;
+            i++;
+            break;
+          }
+        explored_moves += batch_evaluated ? moves.size() : i;
+        if (token.IsCancelled())
+          context.Cancel();
+      },
+                     context, horizon);
+      FirstMoveCandidate result;
+      candidates.CombineEach([&result](const FirstMoveCandidate &candidate) {
+        if (candidate.index < result.index)
+          result = candidate;
+      });
+      if (result.index == std::numeric_limits<size_t>::max())
+      {
+        explored = explored_moves;
+        return EvaluatedMove<MoveType, CostStructureType>::empty;
+      }
+      explored = deterministic ? result.explored : explored_moves.load();
+      return result.first_move;
+    }
     EvaluatedMove<MoveType, CostStructureType> first_move;
-    bool first_move_found = false;
-    tbb::spin_mutex mx_first_move;
-    explored = 0;
-    tbb::parallel_for_each(this->sample_begin(st, samples), this->sample_end(st, samples), [this, &st, &mx_first_move, &first_move, &first_move_found, &explored, AcceptMove, &weights](EvaluatedMove<MoveType, CostStructureType> &mv) {
-      mv.cost = this->DeltaCostFunctionComponents(st, mv.move, weights);
-      mv.is_valid = true;
-      tbb::spin_mutex::scoped_lock lock(mx_first_move);
-      explored++;
-      if (!first_move_found && AcceptMove(mv.move, mv.cost))
+    std::atomic<bool> first_move_found(false);
+    for_each_batch([&first_move, &first_move_found, &EvaluateBatch, &Accept, &explored_moves, &context, &token, batch_evaluated](const std::vector<MoveType> &moves, size_t) {
+      if (first_move_found.load(std::memory_order_relaxed))
+        return;
+      std::vector<CostStructureType> costs(moves.size());
+      EvaluateBatch(moves, costs);
+      size_t i = 0;
+      while (i < moves.size() && !first_move_found.load(std::memory_order_relaxed))
       {
-        first_move_found = true;
-        first_move = mv;
-        tbb::task::self().cancel_group_execution();
+        const size_t k = i++;
+        if (Accept(moves[k], costs[k]))
+        {
+          bool expected = false;
+          if (first_move_found.compare_exchange_strong(expected, true))
+          {
+            first_move = EvaluatedMove<MoveType, CostStructureType>(moves[k], costs[k]);
+            context.Cancel();
+          }
+          break;
+        }
       }
-    });
+      explored_moves += batch_evaluated ? moves.size() : i;
+      if (token.IsCancelled())
+        context.Cancel();
+    },
+                   context, horizon);
+    explored = explored_moves;
     if (!first_move_found)
       return EvaluatedMove<MoveType, CostStructureType>::empty;
     return first_move;
   }
 
-  virtual EvaluatedMove<MoveType, CostStructureType> RandomBest(const State &st, size_t samples, size_t &explored, const MoveAcceptor &AcceptMove, const std::vector<double> &weights = std::vector<double>(0)) const throw(EmptyNeighborhood)
+  /** Evaluates the batches produced by the scheduler in parallel and returns the best accepted move (ties are broken at random, see @ref BestMoveAccumulator). Each thread keeps its own best move, evaluating the acceptance criterion outside of any lock, and the partial results are merged at the end. */
+  template <class Scheduler>
+  EvaluatedMove<MoveType, CostStructureType> ParallelBest(const Scheduler &for_each_batch, const State &st, size_t &explored, const MoveAcceptor &AcceptMove, const std::vector<double> &weights) const
   {
-    tbb::spin_mutex mx_best_move;
-    EvaluatedMove<MoveType, CostStructureType> best_move;
-    unsigned int number_of_bests = 0;
-    explored = 0;
-    tbb::parallel_for_each(this->sample_begin(st, samples), this->sample_end(st, samples), [this, &st, &mx_best_move, &best_move, &number_of_bests, &explored, AcceptMove, &weights](EvaluatedMove<MoveType, CostStructureType> &mv) {
-      mv.cost = this->DeltaCostFunctionComponents(st, mv.move, weights);
-      mv.is_valid = true;
-      tbb::spin_mutex::scoped_lock lock(mx_best_move);
-      explored++;
-      if (AcceptMove(mv.move, mv.cost))
-      {
-        if (number_of_bests == 0)
-        {
-          best_move = mv;
-          number_of_bests = 1;
-        }
-        else if (mv.cost < best_move.cost)
-        {
-          best_move = mv;
-          number_of_bests = 1;
-        }
-        else if (mv.cost == best_move.cost)
-        {
-          if (Random::Uniform<unsigned int>(0, number_of_bests) == 0) // accept the move with probability 1 / (1 + number_of_bests)
-            best_move = mv;
-          number_of_bests++;
-        }
-      }
-    });
-    if (number_of_bests == 0)
+    Parallel::Context context;
+    const CancellationToken token = CancellationToken::Current(); // the workers do not see the token of the calling thread
+    std::atomic<size_t> horizon(std::numeric_limits<size_t>::max());
+    if (!this->slots_resolved)
+      this->ResolveComponentSlots(); // before evaluating moves concurrently
+    // the random streams used to break ties are seeded from the global generator before going concurrent
+    unsigned long seed = Random::Uniform<unsigned long>(0, std::numeric_limits<unsigned long>::max());
+    std::atomic<unsigned long> streams(0);
+    const bool deterministic = this->deterministic;
+    Parallel::ThreadSpecific<BestMoveAccumulator> accumulators([seed, &streams, deterministic]() { return BestMoveAccumulator(seed, streams++, deterministic); });
+    for_each_batch([this, &st, &accumulators, &AcceptMove, &weights, &context, &token](const std::vector<MoveType> &moves, size_t first_index) {
+      std::vector<CostStructureType> costs(moves.size());
+      this->BatchDeltaCostFunctionComponents(st, moves.data(), moves.size(), costs.data(), weights);
+      BestMoveAccumulator &accumulator = accumulators.Local();
+      accumulator.explored += moves.size();
+      for (size_t i = 0; i < moves.size(); i++)
+        if (AcceptMove(moves[i], costs[i]))
+          accumulator.Add(moves[i], costs[i], first_index + i);
+      if (token.IsCancelled())
+        context.Cancel();
+    },
+                   context, horizon);
+    BestMoveAccumulator result(seed, streams++, deterministic);
+    accumulators.CombineEach([&result](const BestMoveAccumulator &accumulator) { result.Merge(accumulator); });
+    explored = result.explored;
+    if (result.number_of_bests == 0)
       return EvaluatedMove<MoveType, CostStructureType>::empty;
-    return best_move;
+    return result.best_move;
+  }
+
+  /** Whether the selected moves must not depend on the number of threads and on their scheduling */
+  bool deterministic = false;
+
+  /** Whether the first-improvement methods must return the accepted move with the lowest position in the exploration order */
+  bool ordered_first = false;
+
+  /** The number of shares of a sampled neighborhood in deterministic mode */
+  static const size_t deterministic_shares = 64;
+
+public:
+  /** Sets whether the selected moves must be a deterministic function of the state, of the random seed and of the exploration order, independently of the number of threads and of their scheduling. In deterministic mode the first-improvement methods return the accepted move with the lowest position in the exploration order, ties between best moves are broken by means of a seeded hash of their positions, and sampled neighborhoods are split in a fixed number of shares.
+       @note The acceptance criterion must be a deterministic function of the move and of its cost (stochastic criteria drawing from the thread generators are not).
+       @note An exploration stopped by the @ref CancellationToken selects among the moves evaluated so far, which depend on the scheduling.
+       @param deterministic whether the deterministic mode is enabled
+       */
+  void SetDeterministic(bool deterministic)
+  {
+    this->deterministic = deterministic;
+  }
+
+  /** Returns whether the deterministic mode is enabled. */
+  bool Deterministic() const
+  {
+    return deterministic;
+  }
+
+  /** Sets whether the first-improvement methods must return the accepted move with the lowest position in the exploration order, i.e., the same move as a serial exploration (which is always the case in deterministic mode). Batches of moves are evaluated speculatively, in the exploration order, and the move is returned once all the batches preceding it have been evaluated.
+       @param ordered_first whether the ordered first-improvement is enabled
+       */
+  void SetOrderedFirst(bool ordered_first)
+  {
+    this->ordered_first = ordered_first;
+  }
+
+  /** Returns whether the ordered first-improvement is enabled. */
+  bool OrderedFirst() const
+  {
+    return ordered_first;
+  }
+
+  virtual EvaluatedMove<MoveType, CostStructureType> SelectFirst(const State &st, size_t &explored, const MoveAcceptor &AcceptMove, const std::vector<double> &weights = std::vector<double>(0)) const
+  {
+    if (this->IsIndexImplemented())
+      return ParallelFirst(OrderedIndexedBatches(st), st, explored, AcceptMove, weights);
+    return ParallelFirst(IteratorBatches(this->begin(st), this->end(st)), st, explored, AcceptMove, weights);
+  }
+
+  virtual EvaluatedMove<MoveType, CostStructureType> SelectFirst(const MoveType &start_move, const State &st, size_t &explored, const MoveAcceptor &AcceptMove, const std::vector<double> &weights = std::vector<double>(0)) const
+  {
+    return ParallelFirst(IteratorBatches(this->begin(start_move, st), this->end(start_move, st)), st, explored, AcceptMove, weights);
+  }
+
+  virtual EvaluatedMove<MoveType, CostStructureType> SelectBest(const State &st, size_t &explored, const MoveAcceptor &AcceptMove, const std::vector<double> &weights = std::vector<double>(0)) const
+  {
+    if (this->IsIndexImplemented())
+      return ParallelBest(IndexedBatches(st), st, explored, AcceptMove, weights);
+    return ParallelBest(IteratorBatches(this->begin(st), this->end(st)), st, explored, AcceptMove, weights);
+  }
+
+  virtual EvaluatedMove<MoveType, CostStructureType> RandomFirst(const State &st, size_t samples, size_t &explored, const MoveAcceptor &AcceptMove, const std::vector<double> &weights = std::vector<double>(0)) const
+  {
+    return ParallelFirst(SampledBatches(st, samples), st, explored, AcceptMove, weights);
+  }
+
+  /** Each share of the sample draws the threshold of each of its moves from its own random stream, right before evaluating the move with early rejection, and passes it to the acceptance criterion, therefore the moves are evaluated and accepted concurrently without any lock. */
+  virtual EvaluatedMove<MoveType, CostStructureType> RandomFirst(const State &st, size_t samples, size_t &explored, const ThresholdMoveAcceptor &AcceptMove, const MoveThreshold &Threshold, const std::vector<double> &weights = std::vector<double>(0)) const
+  {
+    return ParallelFirst(SampledBatches(st, samples), explored, [](const std::vector<MoveType> &, std::vector<CostStructureType> &) {
+      // the moves are evaluated one by one, each one against its own threshold
+    },
+                         [this, &st, &AcceptMove, &Threshold, &weights](const MoveType &mv, CostStructureType &cost) {
+                           const double threshold = Threshold();
+                           return this->BoundedDeltaCostFunctionComponents(st, mv, threshold, cost, weights) && AcceptMove(mv, cost, threshold);
+                         },
+                         false);
+  }
+
+  virtual EvaluatedMove<MoveType, CostStructureType> RandomBest(const State &st, size_t samples, size_t &explored, const MoveAcceptor &AcceptMove, const std::vector<double> &weights = std::vector<double>(0)) const
+  {
+    return ParallelBest(SampledBatches(st, samples), st, explored, AcceptMove, weights);
   }
 };
 } // namespace Core
 } // namespace EasyLocal
-
-#endif
@@ -144,6 +144,11 @@ public:
     return cost_component_index.at(cc.hash);
   }
 
+  bool HasCostComponent(const CostComponent<Input, State, CFtype> &cc) const
+  {
+    return cost_component_index.find(cc.hash) != cost_component_index.end();
+  }
+
   /**
        Clear the cost component array.
        */
@@ -243,7 +248,7 @@ CostStructure StateManager<Input, State, CostStructure>::CostFunctionComponents(
 {
   CFtype hard_cost = 0, soft_cost = 0;
   double weighted_cost = 0.0;
-  std::vector<CFtype> cost_function(CostComponents(), (CFtype)0);
+  typename CostStructure::ComponentsType cost_function(CostComponents(), (CFtype)0);
   for (size_t i = 0; i < cost_component.size(); i++)
   {
     CFtype current_cost = cost_function[i] = cost_component[i]->Cost(st);
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <tuple>
+
+#include "helpers/neighborhoodexplorer.hh"
+#include "utils/tuple.hh"
+
+namespace EasyLocal
+{
+
+namespace Core
+{
+
+/** A neighborhood explorer whose delta cost components are known at compile time. The components are passed as template parameters (their concrete types) and are evaluated by means of statically dispatched calls, which the compiler is able to inline and fuse in a single loop, instead of going through the virtual @ref DeltaCostComponent::DeltaCost. It is a @ref NeighborhoodExplorer, therefore it can be used wherever a @ref NeighborhoodExplorer is expected, and further components can still be added dynamically by means of @ref AddDeltaCostComponent and @ref AddCostComponent.
+     @note The concrete delta cost components must declare @c ComputeDeltaCost as public, and the related cost components must be added to the state manager before the explorer is constructed.
+     @ingroup Helpers
+     */
+template <class Input, class State, class Move, class CostStructure, class... StaticDeltaCostComponents>
+class StaticNeighborhoodExplorer : public NeighborhoodExplorer<Input, State, Move, CostStructure>
+{
+public:
+  typedef typename CostStructure::CFtype CFtype;
+  typedef std::tuple<StaticDeltaCostComponents &...> DeltaCostComponentsType;
+
+  /**
+       Constructs a neighborhood explorer passing an input object, a state manager and the statically dispatched delta cost components.
+
+       @param in a pointer to an input object.
+       @param sm a pointer to a compatible state manager.
+       @param name the name associated to the NeighborhoodExplorer.
+       @param dccs the delta cost components
+       */
+  StaticNeighborhoodExplorer(const Input &in, StateManager<Input, State, CostStructure> &sm, std::string name, StaticDeltaCostComponents &... dccs);
+
+  /** @copydoc NeighborhoodExplorer::DeltaCostFunctionComponents */
+  virtual CostStructure DeltaCostFunctionComponents(const State &st, const Move &mv, const std::vector<double> &weights = std::vector<double>(0)) const;
+
+  /** Computes the differences in the cost function without early rejection, since the statically dispatched components are evaluated as a whole.
+       @copydoc NeighborhoodExplorer::BoundedDeltaCostFunctionComponents */
+  virtual bool BoundedDeltaCostFunctionComponents(const State &st, const Move &mv, double threshold, CostStructure &cost, const std::vector<double> &weights = std::vector<double>(0)) const
+  {
+    cost = DeltaCostFunctionComponents(st, mv, weights);
+    return true;
+  }
+
+  /** @copydoc NeighborhoodExplorer::DeltaCostComponents */
+  virtual size_t DeltaCostComponents() const
+  {
+    return sizeof...(StaticDeltaCostComponents) + NeighborhoodExplorer<Input, State, Move, CostStructure>::DeltaCostComponents();
+  }
+
+protected:
+  /** Evaluates the statically dispatched components, accumulating their contributions. */
+  template <int... S>
+  void StaticDeltaCost(const State &st, const Move &mv, const std::vector<double> &weights, typename CostStructure::ComponentsType &delta_cost_function, CFtype &delta_hard_cost, CFtype &delta_soft_cost, double &delta_weighted_cost, tuple_index<S...>) const
+  {
+    int expand[] = {0, (EvaluateComponent(std::get<S>(dccs), static_index[S], st, mv, weights, delta_cost_function, delta_hard_cost, delta_soft_cost, delta_weighted_cost), 0)...};
+    (void)expand;
+  }
+
+  /** Evaluates a single component by means of a non-virtual (qualified) call to its @c ComputeDeltaCost. */
+  template <class DCC>
+  void EvaluateComponent(const DCC &dcc, size_t index, const State &st, const Move &mv, const std::vector<double> &weights, typename CostStructure::ComponentsType &delta_cost_function, CFtype &delta_hard_cost, CFtype &delta_soft_cost, double &delta_weighted_cost) const
+  {
+    CFtype current_delta_cost = delta_cost_function[index] = dcc.cc.Weight() * dcc.DCC::ComputeDeltaCost(st, mv);
+    if (dcc.IsHard())
+    {
+      delta_hard_cost += current_delta_cost;
+      if (!weights.empty())
+        delta_weighted_cost += HARD_WEIGHT * weights[index] * current_delta_cost;
+    }
+    else
+    {
+      delta_soft_cost += current_delta_cost;
+      if (!weights.empty())
+        delta_weighted_cost += weights[index] * current_delta_cost;
+    }
+  }
+
+  /** The statically dispatched delta cost components */
+  DeltaCostComponentsType dccs;
+
+  /** Positions of the statically dispatched components in the cost structure */
+  std::array<size_t, sizeof...(StaticDeltaCostComponents)> static_index;
+};
+
+/** IMPLEMENTATION */
+
+template <class Input, class State, class Move, class CostStructure, class... StaticDeltaCostComponents>
+StaticNeighborhoodExplorer<Input, State, Move, CostStructure, StaticDeltaCostComponents...>::StaticNeighborhoodExplorer(const Input &in, StateManager<Input, State, CostStructure> &sm, std::string name, StaticDeltaCostComponents &... dccs)
+    : NeighborhoodExplorer<Input, State, Move, CostStructure>(in, sm, name), dccs(dccs...)
+{
+  std::array<const CostComponent<Input, State, CFtype> *, sizeof...(StaticDeltaCostComponents)> ccs = {{&dccs.cc...}};
+  for (size_t i = 0; i < ccs.size(); i++)
+  {
+    if (!sm.HasCostComponent(*ccs[i]))
+      throw std::logic_error("The cost component " + ccs[i]->name + " must be added to the state manager before constructing " + name);
+    static_index[i] = sm.CostComponentIndex(*ccs[i]);
+  }
+}
+
+template <class Input, class State, class Move, class CostStructure, class... StaticDeltaCostComponents>
+CostStructure StaticNeighborhoodExplorer<Input, State, Move, CostStructure, StaticDeltaCostComponents...>::DeltaCostFunctionComponents(const State &st, const Move &mv, const std::vector<double> &weights) const
+{
+  CFtype delta_hard_cost = 0, delta_soft_cost = 0;
+  double delta_weighted_cost = 0.0;
+  typename CostStructure::ComponentsType delta_cost_function(this->sm.CostComponents(), static_cast<CFtype>(0));
+
+  StaticDeltaCost(st, mv, weights, delta_cost_function, delta_hard_cost, delta_soft_cost, delta_weighted_cost, typename make_index<sizeof...(StaticDeltaCostComponents)>::type());
+
+  // the components added dynamically (if any) go through the usual evaluation
+  if (!this->delta_slots.empty() || !this->adapter_slots.empty())
+  {
+    CostStructure dynamic_delta = NeighborhoodExplorer<Input, State, Move, CostStructure>::DeltaCostFunctionComponents(st, mv, weights);
+    delta_hard_cost += dynamic_delta.violations;
+    delta_soft_cost += dynamic_delta.objective;
+    delta_weighted_cost += dynamic_delta.weighted;
+    for (size_t i = 0; i < delta_cost_function.size(); i++)
+      delta_cost_function[i] += dynamic_delta.all_components[i];
+  }
+
+  if (!weights.empty())
+    return CostStructure(HARD_WEIGHT * delta_hard_cost + delta_soft_cost, delta_weighted_cost, delta_hard_cost, delta_soft_cost, delta_cost_function);
+  else
+    return CostStructure(HARD_WEIGHT * delta_hard_cost + delta_soft_cost, delta_hard_cost, delta_soft_cost, delta_cost_function);
+}
+} // namespace Core
+} // namespace EasyLocal
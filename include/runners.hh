@@ -34,9 +34,12 @@
 #include "runners/simulatedannealingevaluationbased.hh"
 #include "runners/simulatedannealingtimebased.hh"
 #include "runners/simulatedannealingwithreheating.hh"
+#include "runners/paralleltempering.hh"
+#include "runners/speculativesimulatedannealing.hh"
 #include "runners/greatdeluge.hh"
 #include "runners/tabusearch.hh"
 #include "runners/firstimprovementtabusearch.hh"
 #include "runners/sampletabusearch.hh"
+#include "runners/reactivetabusearch.hh"
 #include "runners/lateacceptancehillclimbing.hh"
 
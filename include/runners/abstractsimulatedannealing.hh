@@ -1,12 +1,15 @@
 #pragma once
 
 #include <cmath>
+#include <limits>
 #include <stdexcept>
 #include <algorithm>
+#include <vector>
 
 #include "runners/moverunner.hh"
 #include "helpers/statemanager.hh"
 #include "helpers/neighborhoodexplorer.hh"
+#include "utils/weightedsampler.hh"
 
 namespace EasyLocal
 {
@@ -25,6 +28,32 @@ namespace EasyLocal
      
      The stop condition is delegated to the concrete subclasses
      
+     At low temperatures almost all the sampled moves are rejected. If
+     the neighborhood explorer can generate the moves by position (see
+     @ref NeighborhoodExplorer::MoveAt) and it enumerates the moves
+     affected by a move (see @ref
+     NeighborhoodExplorer::IsAffectedMovesImplemented), and the ratio of
+     accepted moves falls below @c rejectionless_ratio, the runner
+     switches to a
+     rejectionless (n-fold way) mode: the costs of all the moves are
+     kept, along with their acceptance probabilities, and the accepted
+     move is drawn directly with probability proportional to its
+     acceptance probability. After each move only the costs of the
+     affected moves (see @ref NeighborhoodExplorer::AffectedMoves) are
+     computed again. The number of moves the plain runner would have
+     sampled up to the accepted one is drawn as well, and the counters of
+     sampled moves and evaluations are advanced by it, so that the
+     cooling schedule and the stop conditions are the same in both
+     modes.
+     @note The rejectionless mode follows the plain one only if @c
+     RandomMove draws the indexed moves uniformly (the number of samples
+     is drawn as if each of them had probability 1 / @c NeighborhoodSize),
+     and if the moves not reported by @c AffectedMoves are generated
+     unchanged by @c MoveAt on the new state, since they are not
+     generated again. Without an implementation of @c AffectedMoves
+     the whole neighborhood would be evaluated again after each move,
+     which is slower than sampling, therefore the mode is not used.
+     
      @ingroup Runners
      */
     template <class Input, class State, class Move, class CostStructure = DefaultCostStructure<int>>
@@ -34,6 +63,17 @@ namespace EasyLocal
       using MoveRunner<Input, State, Move, CostStructure>::MoveRunner;
       
       double Temperature() const { return temperature; }
+      
+      /** Samples the neighborhood of a state until a move is accepted by the Metropolis criterion at a given temperature, i.e., it is an improving move or a worsening one accepted with probability exp(-delta / temperature).
+       @param ne the neighborhood explorer
+       @param st the state
+       @param temperature the temperature
+       @param samples the maximum number of moves sampled
+       @param sampled the number of moves actually sampled
+       @param weights the weights of the cost components
+       @return the accepted move, which is not valid if none has been accepted
+       */
+      static EvaluatedMove<Move, CostStructure> SampleMove(const NeighborhoodExplorer<Input, State, Move, CostStructure> &ne, const State &st, double temperature, size_t samples, size_t &sampled, const std::vector<double> &weights);
     protected:
       void InitializeRun() override;
       void UpdateIterationCounter();
@@ -41,16 +81,35 @@ namespace EasyLocal
       bool AcceptableMove();
       void CompleteMove() override;
       void CompleteIteration() override;
+      /** Draws the accepted move in rejectionless mode. */
+      void SelectMoveWithoutRejections();
+      /** Computes the costs of all the moves of the current state, for the rejectionless mode. */
+      void EvaluateNeighborhood();
+      /** Returns the acceptance probability of a move at the current temperature. */
+      double AcceptanceProbability(const CostStructure &move_cost) const;
       // parameters
       void InitializeParameters() override;
       Parameter<bool> compute_start_temperature;
       Parameter<double> start_temperature;
       Parameter<double> cooling_rate;
       Parameter<unsigned int> max_neighbors_sampled, max_neighbors_accepted;
+      Parameter<double> rejectionless_ratio;
       // state of SA
       double temperature; /**< The current temperature. */
       size_t neighbors_sampled, neighbors_accepted;
       int number_of_temperatures;
+      // state of the rejectionless mode
+      bool rejectionless; /**< Whether the moves are drawn without rejections. */
+      size_t window_sampled, window_accepted; /**< Moves sampled and accepted since the last check of the acceptance ratio. */
+      std::vector<Move> moves; /**< The moves of the current state, by position (empty if they have to be evaluated). */
+      std::vector<CostStructure> move_costs;
+      std::vector<double> move_costs_weights; /**< The weights the costs have been computed with. */
+      WeightedSampler acceptance; /**< The acceptance probabilities of the moves. */
+      double acceptance_temperature; /**< The temperature of the acceptance probabilities. */
+      size_t acceptance_updates; /**< Updates of the acceptance probabilities since they have been assigned. */
+      std::vector<size_t> affected_moves;
+      std::vector<Move> affected_batch;
+      std::vector<CostStructure> affected_costs;
     };
     
     /*************************************************************************
@@ -66,6 +125,8 @@ namespace EasyLocal
       cooling_rate("cooling_rate", "Cooling rate", this->parameters);
       max_neighbors_sampled("neighbors_sampled", "Maximum number of neighbors sampled at each temp.", this->parameters);
       max_neighbors_accepted("neighbors_accepted", "Maximum number of neighbor accepted at each temp.", this->parameters);
+      rejectionless_ratio("rejectionless_ratio", "Ratio of accepted moves below which they are drawn without rejections (0 to disable)", this->parameters);
+      rejectionless_ratio = 0.0;
       if (!compute_start_temperature.IsSet())
         compute_start_temperature = false; // FIXME!!
     }
@@ -121,6 +182,10 @@ namespace EasyLocal
       neighbors_accepted = 0;
       
       number_of_temperatures = 1;
+      
+      rejectionless = false;
+      window_sampled = window_accepted = 0;
+      moves.clear();
     }
     
     /**
@@ -129,17 +194,108 @@ namespace EasyLocal
     template <class Input, class State, class Move, class CostStructure>
     void AbstractSimulatedAnnealing<Input, State, Move, CostStructure>::SelectMove()
     {
+      if (rejectionless)
+      {
+        if (moves.empty() || move_costs_weights != this->weights)
+          EvaluateNeighborhood();
+        if (acceptance_temperature != temperature || acceptance_updates >= moves.size())
+        {
+          std::vector<double> probabilities(moves.size());
+          for (size_t i = 0; i < moves.size(); i++)
+            probabilities[i] = AcceptanceProbability(move_costs[i]);
+          acceptance.Assign(probabilities); // also clears the rounding errors of the updates
+          acceptance_temperature = temperature;
+          acceptance_updates = 0;
+        }
+        if (acceptance.Total() < rejectionless_ratio * moves.size())
+        {
+          SelectMoveWithoutRejections();
+          return;
+        }
+        // e.g., the temperature has been raised, and sampling is cheaper than updating the costs
+        rejectionless = false;
+        moves.clear();
+      }
       // TODO: it should become a parameter, the number of neighbors drawn at each iteration (possibly evaluated in parallel)
       size_t sampled;
-      double t = this->temperature;
-      EvaluatedMove<Move, CostStructure> em = this->ne.RandomFirst(*this->p_current_state, this->max_neighbors_sampled - neighbors_sampled, sampled, [t](const Move &mv, const CostStructure &move_cost) {
-        double r = std::max(Random::Uniform<double>(0.0, 1.0), std::numeric_limits<double>::epsilon());
-        return move_cost <= 0 || move_cost < (-t * log(r));
-      },
-                                                                   this->weights);
+      EvaluatedMove<Move, CostStructure> em = SampleMove(this->ne, *this->p_current_state, this->temperature, this->max_neighbors_sampled - neighbors_sampled, sampled, this->weights);
       this->current_move = em;
       neighbors_sampled += sampled;
       this->evaluations += sampled;
+      if (rejectionless_ratio > 0.0 && this->ne.IsIndexImplemented() && this->ne.IsAffectedMovesImplemented())
+      {
+        // the ratio is checked over as many samples as the moves to evaluate in rejectionless mode
+        window_sampled += sampled;
+        window_accepted += em.is_valid;
+        if (window_sampled >= this->ne.NeighborhoodSize(*this->p_current_state))
+        {
+          rejectionless = window_accepted < rejectionless_ratio * window_sampled;
+          window_sampled = window_accepted = 0;
+        }
+      }
+    }
+    
+    template <class Input, class State, class Move, class CostStructure>
+    void AbstractSimulatedAnnealing<Input, State, Move, CostStructure>::SelectMoveWithoutRejections()
+    {
+      const size_t remaining = neighbors_sampled < max_neighbors_sampled ? max_neighbors_sampled - neighbors_sampled : 1;
+      const double total = acceptance.Total(), p = total / moves.size();
+      // the samples up to the first accepted one are geometrically distributed
+      double trials = std::numeric_limits<double>::infinity();
+      if (p >= 1.0)
+        trials = 1.0;
+      else if (p > 0.0)
+        trials = 1.0 + std::floor(std::log(std::max(Random::Uniform<double>(0.0, 1.0), std::numeric_limits<double>::epsilon())) / std::log1p(-p));
+      if (trials > remaining)
+      {
+        // no move would have been accepted among the remaining samples
+        this->current_move = EvaluatedMove<Move, CostStructure>();
+        neighbors_sampled += remaining;
+        this->evaluations += remaining;
+        return;
+      }
+      size_t i = acceptance.Sample(Random::Uniform<double>(0.0, total));
+      this->current_move = EvaluatedMove<Move, CostStructure>(moves[i], move_costs[i]);
+      neighbors_sampled += static_cast<size_t>(trials);
+      this->evaluations += static_cast<size_t>(trials);
+    }
+    
+    template <class Input, class State, class Move, class CostStructure>
+    void AbstractSimulatedAnnealing<Input, State, Move, CostStructure>::EvaluateNeighborhood()
+    {
+      const size_t n = this->ne.NeighborhoodSize(*this->p_current_state);
+      if (n == 0)
+        throw EmptyNeighborhood();
+      moves.resize(n);
+      move_costs.resize(n);
+      for (size_t i = 0; i < n; i++)
+        this->ne.MoveAt(*this->p_current_state, i, moves[i]);
+      this->ne.BatchDeltaCostFunctionComponents(*this->p_current_state, moves.data(), n, move_costs.data(), this->weights);
+      move_costs_weights = this->weights;
+      acceptance_temperature = std::numeric_limits<double>::quiet_NaN(); // to be assigned
+    }
+    
+    template <class Input, class State, class Move, class CostStructure>
+    double AbstractSimulatedAnnealing<Input, State, Move, CostStructure>::AcceptanceProbability(const CostStructure &move_cost) const
+    {
+      if (move_cost <= 0)
+        return 1.0;
+      return std::exp(-(move_cost.is_weighted ? move_cost.weighted : static_cast<double>(move_cost.total)) / temperature);
+    }
+    
+    template <class Input, class State, class Move, class CostStructure>
+    EvaluatedMove<Move, CostStructure> AbstractSimulatedAnnealing<Input, State, Move, CostStructure>::SampleMove(const NeighborhoodExplorer<Input, State, Move, CostStructure> &ne, const State &st, double temperature, size_t samples, size_t &sampled, const std::vector<double> &weights)
+    {
+      double t = temperature;
+      // the acceptance threshold is drawn before evaluating each move, so that the moves exceeding it can be rejected early
+      return ne.RandomFirst(st, samples, sampled, [](const Move &mv, const CostStructure &move_cost, double threshold) {
+        return move_cost <= 0 || move_cost < threshold;
+      },
+                            [t]() {
+                              double r = std::max(Random::Uniform<double>(0.0, 1.0), std::numeric_limits<double>::epsilon());
+                              return -t * log(r);
+                            },
+                            weights);
     }
     
     /**
@@ -149,6 +305,29 @@ namespace EasyLocal
     void AbstractSimulatedAnnealing<Input, State, Move, CostStructure>::CompleteMove()
     {
       neighbors_accepted++;
+      if (!rejectionless || moves.empty())
+        return;
+      if (this->ne.NeighborhoodSize(*this->p_current_state) != moves.size())
+      {
+        moves.clear(); // evaluated again at the next iteration
+        return;
+      }
+      affected_moves.clear();
+      this->ne.AffectedMoves(*this->p_current_state, this->current_move.move, affected_moves);
+      // the affected moves are evaluated in a single batch
+      affected_batch.resize(affected_moves.size());
+      affected_costs.resize(affected_moves.size());
+      for (size_t k = 0; k < affected_moves.size(); k++)
+        this->ne.MoveAt(*this->p_current_state, affected_moves[k], affected_batch[k]);
+      this->ne.BatchDeltaCostFunctionComponents(*this->p_current_state, affected_batch.data(), affected_batch.size(), affected_costs.data(), this->weights);
+      for (size_t k = 0; k < affected_moves.size(); k++)
+      {
+        const size_t i = affected_moves[k];
+        moves[i] = affected_batch[k];
+        move_costs[i] = affected_costs[k];
+        acceptance.Set(i, AcceptanceProbability(move_costs[i]));
+      }
+      acceptance_updates += affected_moves.size();
     }
     
     /**
@@ -39,10 +39,7 @@ namespace EasyLocal
       CFtype aspiration = this->best_state_cost.total - this->current_state_cost.total;
       size_t explored;
       EvaluatedMove<Move, CostStructure> em = this->ne.SelectFirst(*this->p_current_state, explored, [this, aspiration](const Move &mv, const CostStructure &move_cost) {
-        for (auto li : *(this->tabu_list))
-          if ((move_cost.total >= aspiration) && this->Inverse(li.move, mv))
-            return false;
-        return true;
+        return !(move_cost.total >= aspiration && this->IsTabu(mv));
       },
                                                                    this->weights);
       this->current_move = em;
@@ -86,9 +86,12 @@ namespace EasyLocal
       size_t sampled;
       CFtype cur_cost = this->current_state_cost.total;
       double l = level;
-      EvaluatedMove<Move, CostStructure> em = this->ne.RandomFirst(*this->p_current_state, samples, sampled, [cur_cost, l](const Move &mv, const CostStructure &move_cost) {
+      EvaluatedMove<Move, CostStructure> em = this->ne.RandomFirst(*this->p_current_state, samples, sampled, [cur_cost, l](const Move &mv, const CostStructure &move_cost, double) {
         return move_cost < 0.0 || move_cost <= l - cur_cost;
       },
+                                                                   [cur_cost, l]() {
+                                                                     return std::max(0.0, l - cur_cost);
+                                                                   },
                                                                    this->weights);
       this->current_move = em;
     }
@@ -53,9 +53,12 @@ namespace EasyLocal
       // TODO: it should become a parameter, the number of neighbors drawn at each iteration (possibly evaluated in parallel)
       const size_t samples = 10;
       size_t sampled;
-      EvaluatedMove<Move, CostStructure> em = this->ne.RandomFirst(*this->p_current_state, samples, sampled, [](const Move &mv, const CostStructure &move_cost) {
+      EvaluatedMove<Move, CostStructure> em = this->ne.RandomFirst(*this->p_current_state, samples, sampled, [](const Move &mv, const CostStructure &move_cost, double) {
         return move_cost <= 0;
       },
+                                                                   []() {
+                                                                     return 0.0;
+                                                                   },
                                                                    this->weights);
       this->current_move = em;
       this->evaluations += static_cast<unsigned long int>(sampled);
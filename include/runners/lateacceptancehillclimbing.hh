@@ -71,9 +71,13 @@ namespace EasyLocal
       size_t sampled;
       CostStructure prev_step_delta_cost = previous_steps[this->iteration % steps] - this->current_state_cost;
       // TODO: check shifting penalty meaningfullness
-      EvaluatedMove<Move, CostStructure> em = this->ne.RandomFirst(*this->p_current_state, samples, sampled, [prev_step_delta_cost](const Move &mv, const CostStructure &move_cost) {
+      EvaluatedMove<Move, CostStructure> em = this->ne.RandomFirst(*this->p_current_state, samples, sampled, [prev_step_delta_cost](const Move &mv, const CostStructure &move_cost, double) {
         return move_cost <= 0 || move_cost <= prev_step_delta_cost;
       },
+                                                                   [this, prev_step_delta_cost]() {
+                                                                     // with weights the comparison of the structures may fall back to their totals, hence no threshold is given
+                                                                     return this->weights.empty() ? std::max(0.0, static_cast<double>(prev_step_delta_cost.total)) : std::numeric_limits<double>::infinity();
+                                                                   },
                                                                    this->weights);
       this->current_move = em;
       this->evaluations += sampled;
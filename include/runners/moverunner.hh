@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include "runners/runner.hh"
 #include "helpers/statemanager.hh"
 #include "helpers/neighborhoodexplorer.hh"
@@ -13,6 +15,7 @@ namespace Core
 /** A Move Runner is an instance of the Runner interface which it compels to
      with a particular definition of @Move (given as template instantiation).
      It is at the root of the inheritance hierarchy of actual runners.
+     The best state is not copied at each improvement, since the current state is the best one until the search moves away from it: the copy is made right before a move which does not improve the best state, or, if the neighborhood explorer implements @ref NeighborhoodExplorer::UndoMove, the moves applied since the best state are recorded and the copy is only made when the best state is needed (i.e., at the end of the run, for the readers or when the moves recorded are too many), by reverting them on a copy of the current state.
      @ingroup Runners
      */
 template <class Input, class State, class Move, class CostStructure = DefaultCostStructure<int>>
@@ -41,6 +44,18 @@ protected:
   virtual void MakeMove();
 
   void UpdateBestState() final;
+
+  /** Checks whether a cost is better than the one of the best state. */
+  bool IsBetterThanBest(const CostStructure &cost) const;
+
+  /** Checks whether a cost is better than another one, i.e., it has less violations or, with the same violations, a lower total. */
+  static bool IsBetter(const CostStructure &cost, const CostStructure &other);
+
+  virtual void MaterializeBestState();
+
+  /** Binds the current state to the neighborhood explorer, so that the explorer can cache information about it. */
+  virtual void CurrentStateChanged();
+
   void UpdateStateCost();
 
   NeighborhoodExplorer<Input, State, Move, CostStructure> &ne; /**< A reference to the
@@ -49,20 +64,41 @@ protected:
 
   // data
   EvaluatedMove<Move, CostStructure> current_move; /**< The currently selected move. */
+
+  /** Whether the best state is the current one, with the moves of the trail reverted, rather than @c p_best_state */
+  bool best_state_deferred;
+
+  /** The moves applied to the current state since the best one, if the explorer can undo them */
+  std::vector<Move> trail;
+
+  /** The maximum number of moves in the trail, beyond which the best state is materialized */
+  static const size_t max_trail_length = 1024;
 };
 
 /*************************************************************************
      * Implementation
      *************************************************************************/
 
+template <class Input, class State, class Move, class CostStructure>
+bool MoveRunner<Input, State, Move, CostStructure>::IsBetterThanBest(const CostStructure &cost) const
+{
+  return IsBetter(cost, this->best_state_cost);
+}
+
+template <class Input, class State, class Move, class CostStructure>
+bool MoveRunner<Input, State, Move, CostStructure>::IsBetter(const CostStructure &cost, const CostStructure &other)
+{
+  return LessThan(cost.violations, other.violations) || (EqualTo(cost.violations, other.violations) && LessThan(cost.total, other.total));
+}
+
 template <class Input, class State, class Move, class CostStructure>
 void MoveRunner<Input, State, Move, CostStructure>::UpdateBestState()
 {
-  if (LessThan(this->current_state_cost.violations, this->best_state_cost.violations) || (EqualTo(this->current_state_cost.violations, this->best_state_cost.violations) &&
-                                                                                          (LessThan(this->current_state_cost.total, this->best_state_cost.total))))
+  if (IsBetterThanBest(this->current_state_cost))
   {
-    std::lock_guard<std::mutex> lock(this->best_state_mutex);
-    *(this->p_best_state) = *(this->p_current_state);
+    // the copy of the state is deferred until the search moves away from it (see MakeMove)
+    best_state_deferred = true;
+    trail.clear();
     this->best_state_cost = this->current_state_cost;
 
     // so that idle iterations are printed correctly
@@ -72,13 +108,31 @@ void MoveRunner<Input, State, Move, CostStructure>::UpdateBestState()
   }
 }
 
+template <class Input, class State, class Move, class CostStructure>
+void MoveRunner<Input, State, Move, CostStructure>::MaterializeBestState()
+{
+  if (!best_state_deferred)
+    return;
+  *(this->p_best_state) = *(this->p_current_state);
+  for (auto it = trail.rbegin(); it != trail.rend(); ++it)
+    ne.UndoMove(*(this->p_best_state), *it);
+  trail.clear();
+  best_state_deferred = false;
+}
+
 template <class Input, class State, class Move, class CostStructure>
 MoveRunner<Input, State, Move, CostStructure>::MoveRunner(const Input &in,
                                                           StateManager<Input, State, CostStructure> &e_sm,
                                                           NeighborhoodExplorer<Input, State, Move, CostStructure> &e_ne,
                                                           std::string name)
-    : Runner<Input, State, CostStructure>(in, e_sm, name), ne(e_ne)
+    : Runner<Input, State, CostStructure>(in, e_sm, name), ne(e_ne), best_state_deferred(false)
+{
+}
+
+template <class Input, class State, class Move, class CostStructure>
+void MoveRunner<Input, State, Move, CostStructure>::CurrentStateChanged()
 {
+  ne.BindState(this->p_current_state);
 }
 
 template <class Input, class State, class Move, class CostStructure>
@@ -89,6 +143,7 @@ void MoveRunner<Input, State, Move, CostStructure>::InitializeRun()
 template <class Input, class State, class Move, class CostStructure>
 void MoveRunner<Input, State, Move, CostStructure>::TerminateRun()
 {
+  ne.UnbindState(); // releases what the explorer keeps for the current state
 }
 
 template <class Input, class State, class Move, class CostStructure>
@@ -106,8 +161,17 @@ void MoveRunner<Input, State, Move, CostStructure>::MakeMove()
 {
   if (current_move.is_valid)
   {
+    if (best_state_deferred)
+    {
+      // the current state is about to move away from the best one, unless the move improves it
+      if (ne.IsUndoImplemented() && trail.size() < max_trail_length)
+        trail.push_back(current_move.move);
+      else if (!trail.empty() || !IsBetterThanBest(this->current_state_cost + current_move.cost))
+        MaterializeBestState();
+    }
     ne.MakeMove(*this->p_current_state, current_move.move);
     this->current_state_cost += current_move.cost;
+    ne.BindState(this->p_current_state, current_move.move); // the explorer can keep what is not affected by the move
     //this->logtrace("Runner {}, iteration {}, move {}, move cost {}, current cost {}", this->name, this->iteration, current_move.cost, this->current_state_cost);
   }
 }
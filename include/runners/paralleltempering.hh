@@ -0,0 +1,279 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "runners/abstractsimulatedannealing.hh"
+#include "utils/cancellation.hh"
+#include "utils/parallel.hh"
+
+namespace EasyLocal
+{
+
+  namespace Core
+  {
+
+    /** The Parallel Tempering (or replica exchange) runner evolves several
+     replicas of the state in parallel, each one by means of a simulated
+     annealing chain at a fixed temperature. The temperatures form a
+     geometric ladder between the minimum and the maximum one.
+
+     At each iteration (a round) every replica samples a given number of
+     neighbors, accepting them by the Metropolis criterion of @ref
+     AbstractSimulatedAnnealing, and then the replicas at adjacent
+     temperatures exchange their states with probability
+     min(1, exp((E_i - E_j)(1 / T_i - 1 / T_j))), alternating the even and
+     the odd pairs at each round, where E is the cost of a replica
+     (weighted by the weights of the runner, which are shared by all the
+     replicas, if they are given). Good states found by the hot replicas
+     can therefore descend the ladder, and the cold replicas can escape
+     from local minima by climbing it.
+
+     The current state of the runner is the one of the coldest replica,
+     and the best state is the best one found by any replica.
+     @note The replicas are evolved on the threads of @ref Parallel, and the
+     moves are evaluated concurrently on different states: the neighborhood
+     explorer and the cost components must not modify shared data while
+     evaluating moves.
+     @ingroup Runners
+     */
+    template <class Input, class State, class Move, class CostStructure = DefaultCostStructure<int>>
+    class ParallelTempering : public MoveRunner<Input, State, Move, CostStructure>
+    {
+    public:
+      using MoveRunner<Input, State, Move, CostStructure>::MoveRunner;
+
+      std::string StatusString() const;
+
+    protected:
+      void InitializeParameters() override;
+      void InitializeRun() override;
+      bool StopCriterion() override;
+      void SelectMove() override;
+      bool AcceptableMoveFound() override;
+      void MakeMove() override;
+      void CompleteMove() override;
+
+      /** A state evolved at a fixed temperature */
+      struct Replica
+      {
+        std::shared_ptr<State> state;
+        CostStructure cost;
+        /** The cost driving the chain, i.e., the total cost, or the weighted one if weights are given (as in the acceptance of the moves) */
+        double energy;
+        double temperature;
+        /** The random stream of the replica, so that the run does not depend on the scheduling */
+        Random::Engine generator;
+        /** Best state found in the current round, if it is better than the best state of the runner */
+        std::shared_ptr<State> best_state;
+        CostStructure best_state_cost;
+        bool improved;
+        size_t sampled;
+        /** Exchanges attempted and accepted with the next replica */
+        unsigned long int exchanges, accepted_exchanges;
+      };
+
+      /** Replicas, in increasing order of temperature */
+      std::vector<Replica> replicas;
+      /** The weights the energies of the replicas are computed with */
+      std::vector<double> energy_weights;
+
+      // parameters
+      Parameter<unsigned int> number_of_replicas;
+      Parameter<double> min_temperature, max_temperature;
+      Parameter<unsigned int> neighbors_sampled;
+      Parameter<unsigned long int> max_idle_iterations;
+    };
+
+    /*************************************************************************
+     * Implementation
+     *************************************************************************/
+
+    template <class Input, class State, class Move, class CostStructure>
+    void ParallelTempering<Input, State, Move, CostStructure>::InitializeParameters()
+    {
+      MoveRunner<Input, State, Move, CostStructure>::InitializeParameters();
+      number_of_replicas("replicas", "Number of replicas", this->parameters);
+      min_temperature("min_temperature", "Temperature of the coldest replica", this->parameters);
+      max_temperature("max_temperature", "Temperature of the hottest replica", this->parameters);
+      neighbors_sampled("neighbors_sampled", "Number of neighbors sampled by each replica between exchanges", this->parameters);
+      max_idle_iterations("max_idle_iterations", "Maximum number of rounds without improvement", this->parameters);
+      number_of_replicas = static_cast<unsigned int>(Parallel::MaxConcurrency());
+      max_idle_iterations = std::numeric_limits<unsigned long int>::max();
+    }
+
+    /**
+     Initializes the run by invoking the companion superclass method, and
+     copying the state in the replicas along the temperature ladder.
+     */
+    template <class Input, class State, class Move, class CostStructure>
+    void ParallelTempering<Input, State, Move, CostStructure>::InitializeRun()
+    {
+      MoveRunner<Input, State, Move, CostStructure>::InitializeRun();
+      if (number_of_replicas == 0)
+        throw IncorrectParameterValue(number_of_replicas, "should be greater than zero");
+      if (min_temperature <= 0.0)
+        throw IncorrectParameterValue(min_temperature, "should be greater than zero");
+      if (max_temperature < min_temperature)
+        throw IncorrectParameterValue(max_temperature, "should be greater than or equal to min_temperature");
+      if (neighbors_sampled == 0)
+        throw IncorrectParameterValue(neighbors_sampled, "should be greater than zero");
+
+      this->ne.ResolveComponentSlots(); // the moves are evaluated concurrently
+      unsigned int seed = Random::Uniform<unsigned int>(0, std::numeric_limits<unsigned int>::max());
+      replicas.resize(number_of_replicas);
+      for (size_t r = 0; r < replicas.size(); r++)
+      {
+        Replica &replica = replicas[r];
+        replica.state = r == 0 ? this->p_current_state : std::make_shared<State>(*this->p_current_state);
+        replica.cost = this->current_state_cost;
+        replica.temperature = replicas.size() == 1 ? min_temperature : min_temperature * std::pow(max_temperature / min_temperature, static_cast<double>(r) / (replicas.size() - 1));
+        replica.generator.seed(seed + static_cast<unsigned int>(r));
+        replica.best_state.reset();
+        replica.exchanges = replica.accepted_exchanges = 0;
+      }
+      energy_weights.clear();
+      for (Replica &replica : replicas)
+        replica.energy = static_cast<double>(replica.cost.total);
+    }
+
+    template <class Input, class State, class Move, class CostStructure>
+    bool ParallelTempering<Input, State, Move, CostStructure>::StopCriterion()
+    {
+      return this->iteration - this->iteration_of_best >= max_idle_iterations;
+    }
+
+    /**
+     Evolves the replicas in parallel, each one for the given number of samples.
+     */
+    template <class Input, class State, class Move, class CostStructure>
+    void ParallelTempering<Input, State, Move, CostStructure>::SelectMove()
+    {
+      // the replicas modify their states, including the current one, which might be the best one as well
+      this->MaterializeBestState();
+      this->ne.UnbindState();
+      const CancellationToken token = CancellationToken::Current();
+      const size_t samples = neighbors_sampled;
+      if (energy_weights != this->weights)
+      {
+        // e.g., the weights have been set or changed since the previous round
+        for (Replica &replica : replicas)
+        {
+          const CostStructure cost = this->sm.CostFunctionComponents(*replica.state, this->weights);
+          replica.energy = cost.is_weighted ? cost.weighted : static_cast<double>(cost.total);
+        }
+        energy_weights = this->weights;
+      }
+      for (Replica &replica : replicas)
+      {
+        replica.best_state_cost = this->best_state_cost;
+        replica.improved = false;
+        replica.sampled = 0;
+      }
+      Parallel::Context context;
+      Parallel::For(0, replicas.size(), 1, [this, &token, samples](size_t first, size_t last) {
+        CancellationToken::Scope cancellation(token);
+        for (size_t r = first; r < last; r++)
+        {
+          Replica &replica = replicas[r];
+          Random::ScopedStream stream(replica.generator);
+          while (replica.sampled < samples && !token.IsCancelled())
+          {
+            size_t sampled;
+            EvaluatedMove<Move, CostStructure> em = AbstractSimulatedAnnealing<Input, State, Move, CostStructure>::SampleMove(this->ne, *replica.state, replica.temperature, samples - replica.sampled, sampled, this->weights);
+            replica.sampled += sampled;
+            if (!em.is_valid)
+              break;
+            this->ne.MakeMove(*replica.state, em.move);
+            replica.cost += em.cost;
+            replica.energy += em.cost.is_weighted ? em.cost.weighted : static_cast<double>(em.cost.total);
+            if (MoveRunner<Input, State, Move, CostStructure>::IsBetter(replica.cost, replica.best_state_cost))
+            {
+              if (!replica.best_state)
+                replica.best_state = std::make_shared<State>(*replica.state);
+              else
+                *replica.best_state = *replica.state;
+              replica.best_state_cost = replica.cost;
+              replica.improved = true;
+            }
+          }
+        }
+      },
+                    context);
+      for (const Replica &replica : replicas)
+        this->evaluations += replica.sampled;
+    }
+
+    /** The round is completed whether or not the replicas have moved. */
+    template <class Input, class State, class Move, class CostStructure>
+    bool ParallelTempering<Input, State, Move, CostStructure>::AcceptableMoveFound()
+    {
+      return true;
+    }
+
+    /**
+     Exchanges the states of the replicas at adjacent temperatures, and makes
+     the state of the coldest replica the current one.
+     */
+    template <class Input, class State, class Move, class CostStructure>
+    void ParallelTempering<Input, State, Move, CostStructure>::MakeMove()
+    {
+      for (size_t r = this->iteration % 2; r + 1 < replicas.size(); r += 2)
+      {
+        Replica &cold = replicas[r], &hot = replicas[r + 1];
+        double exponent = (cold.energy - hot.energy) * (1.0 / cold.temperature - 1.0 / hot.temperature);
+        cold.exchanges++;
+        if (exponent >= 0.0 || Random::Uniform<double>(0.0, 1.0) < std::exp(exponent))
+        {
+          std::swap(cold.state, hot.state);
+          std::swap(cold.cost, hot.cost);
+          std::swap(cold.energy, hot.energy);
+          cold.accepted_exchanges++;
+        }
+      }
+      this->p_current_state = replicas[0].state;
+      this->current_state_cost = replicas[0].cost;
+      this->CurrentStateChanged();
+    }
+
+    /**
+     Makes the best state found by the replicas in the round (if any) the best state of the runner.
+     */
+    template <class Input, class State, class Move, class CostStructure>
+    void ParallelTempering<Input, State, Move, CostStructure>::CompleteMove()
+    {
+      Replica *best = nullptr;
+      for (Replica &replica : replicas)
+        if (replica.improved && (best == nullptr || MoveRunner<Input, State, Move, CostStructure>::IsBetter(replica.best_state_cost, best->best_state_cost)))
+          best = &replica;
+      if (best == nullptr || !this->IsBetterThanBest(best->best_state_cost))
+        return;
+      std::swap(this->p_best_state, best->best_state);
+      this->best_state_cost = best->best_state_cost;
+      this->iteration_of_best = this->iteration;
+    }
+
+    /**
+     Create a string containing the status of the runner
+     */
+    template <class Input, class State, class Move, class CostStructure>
+    std::string ParallelTempering<Input, State, Move, CostStructure>::StatusString() const
+    {
+      std::stringstream status;
+      status << "[";
+      for (size_t r = 0; r < replicas.size(); r++)
+      {
+        if (r > 0)
+          status << ", ";
+        status << "T = " << replicas[r].temperature << ": " << replicas[r].cost.total;
+        if (r + 1 < replicas.size() && replicas[r].exchanges > 0)
+          status << " (exchanges " << static_cast<double>(replicas[r].accepted_exchanges) / replicas[r].exchanges << ")";
+      }
+      status << "]";
+      return status.str();
+    }
+  } // namespace Core
+} // namespace EasyLocal
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "runners/tabusearch.hh"
+
+namespace EasyLocal
+{
+
+  namespace Core
+  {
+
+    /** The Reactive Tabu Search runner (Battiti and Tecchiolli) differs
+     from the @ref TabuSearch runner in the tenure, which is adapted to
+     the landscape during the run instead of being fixed.
+
+     The visited states are recorded by means of their fingerprints,
+     which are updated at each move by the neighborhood explorer (see
+     @ref NeighborhoodExplorer::FingerprintDelta), so that the whole state
+     is never hashed. Each time a state is visited again the tenure is
+     increased, and it is decreased when no state is repeated for longer
+     than the average length of the recent cycles. When too many states
+     are repeated too often, the search is trapped in a region which the
+     tenure alone cannot escape from, therefore a random walk,
+     whose length grows with the average length of the cycles, takes it
+     elsewhere (the states it visits are recorded as well). At most @c
+     max_visited_states states are remembered: when they are exceeded,
+     the least recently visited half is forgotten.
+
+     The tenure ranges from the minimum to the maximum tenure, starting
+     from the minimum one.
+     @ingroup Runners
+     */
+    template <class Input, class State, class Move, class CostStructure = DefaultCostStructure<int>>
+    class ReactiveTabuSearch : public TabuSearch<Input, State, Move, CostStructure>
+    {
+    public:
+      using TabuSearch<Input, State, Move, CostStructure>::TabuSearch;
+
+      std::string StatusString() const;
+
+    protected:
+      void InitializeParameters();
+      void InitializeRun();
+      void MakeMove();
+      void CompleteMove();
+      unsigned int Tenure();
+      /** Performs a random walk from the current state. */
+      void Escape();
+      /** Records the first visit to the current state, forgetting the least recently visited states if they are too many. */
+      void AddVisit();
+
+      /** The visits to a state */
+      struct Visit
+      {
+        unsigned long int last_iteration;
+        unsigned int repetitions;
+      };
+
+      /** Fingerprint of the current state (the one of the initial state is 0) */
+      size_t fingerprint;
+      /** The visited states, indexed by fingerprint */
+      std::unordered_map<size_t, Visit> visits;
+      double tenure;
+      /** Average length of the cycles */
+      double cycle_length;
+      unsigned long int iteration_of_tenure_change;
+      /** Number of states which have become repeated more than @c max_repetitions times since the last escape */
+      unsigned int chaotic_states;
+
+      // parameters
+      Parameter<double> tenure_increase, tenure_decrease;
+      Parameter<unsigned int> max_repetitions, max_chaotic_states, max_visited_states;
+    };
+
+    /*************************************************************************
+     * Implementation
+     *************************************************************************/
+
+    template <class Input, class State, class Move, class CostStructure>
+    void ReactiveTabuSearch<Input, State, Move, CostStructure>::InitializeParameters()
+    {
+      TabuSearch<Input, State, Move, CostStructure>::InitializeParameters();
+      tenure_increase("tenure_increase", "Factor increasing the tenure when a state is repeated", this->parameters);
+      tenure_decrease("tenure_decrease", "Factor decreasing the tenure when no state is repeated", this->parameters);
+      max_repetitions("max_repetitions", "Number of visits making a state often repeated", this->parameters);
+      max_chaotic_states("max_chaotic_states", "Number of often repeated states triggering an escape", this->parameters);
+      max_visited_states("max_visited_states", "Number of visited states remembered", this->parameters);
+      tenure_increase = 1.1;
+      tenure_decrease = 0.9;
+      max_repetitions = 3;
+      max_chaotic_states = 3;
+      max_visited_states = 100000;
+    }
+
+    /**
+     Initializes the run by invoking the companion superclass method, and
+     forgetting the visited states.
+     */
+    template <class Input, class State, class Move, class CostStructure>
+    void ReactiveTabuSearch<Input, State, Move, CostStructure>::InitializeRun()
+    {
+      if (!this->ne.IsFingerprintImplemented())
+        throw std::logic_error("Reactive tabu search " + this->name + " requires FingerprintDelta in the neighborhood explorer");
+      if (max_visited_states < 2)
+        throw IncorrectParameterValue(max_visited_states, "should be at least 2");
+      TabuSearch<Input, State, Move, CostStructure>::InitializeRun();
+      fingerprint = 0;
+      visits.clear();
+      visits[fingerprint] = Visit{this->iteration, 1};
+      tenure = this->min_tenure;
+      cycle_length = 1.0;
+      iteration_of_tenure_change = this->iteration;
+      chaotic_states = 0;
+    }
+
+    template <class Input, class State, class Move, class CostStructure>
+    void ReactiveTabuSearch<Input, State, Move, CostStructure>::MakeMove()
+    {
+      if (this->current_move.is_valid)
+        fingerprint ^= this->ne.FingerprintDelta(*this->p_current_state, this->current_move.move);
+      TabuSearch<Input, State, Move, CostStructure>::MakeMove();
+    }
+
+    /**
+     Checks whether the new state has been already visited, reacting on the
+     tenure (or escaping), and stores the move in the tabu memory.
+     */
+    template <class Input, class State, class Move, class CostStructure>
+    void ReactiveTabuSearch<Input, State, Move, CostStructure>::CompleteMove()
+    {
+      auto it = visits.find(fingerprint);
+      if (it == visits.end())
+        AddVisit();
+      else
+      {
+        unsigned long int length = this->iteration - it->second.last_iteration;
+        it->second.last_iteration = this->iteration;
+        // each state is counted once, when it becomes often repeated
+        if (++it->second.repetitions == max_repetitions + 1 && ++chaotic_states > max_chaotic_states)
+        {
+          chaotic_states = 0;
+          TabuSearch<Input, State, Move, CostStructure>::CompleteMove();
+          Escape();
+          return;
+        }
+        cycle_length = 0.1 * length + 0.9 * cycle_length;
+        tenure = std::min<double>(std::max(tenure * tenure_increase, tenure + 1.0), this->max_tenure);
+        iteration_of_tenure_change = this->iteration;
+      }
+      if (this->iteration - iteration_of_tenure_change > cycle_length)
+      {
+        tenure = std::max<double>(std::min(tenure * tenure_decrease, tenure - 1.0), this->min_tenure);
+        iteration_of_tenure_change = this->iteration;
+      }
+      TabuSearch<Input, State, Move, CostStructure>::CompleteMove();
+    }
+
+    template <class Input, class State, class Move, class CostStructure>
+    unsigned int ReactiveTabuSearch<Input, State, Move, CostStructure>::Tenure()
+    {
+      return static_cast<unsigned int>(std::lround(tenure));
+    }
+
+    /**
+     Performs a random walk of length between 1 and (1 + average cycle length) / 2,
+     whose moves become tabu as the ones selected by the search.
+     */
+    template <class Input, class State, class Move, class CostStructure>
+    void ReactiveTabuSearch<Input, State, Move, CostStructure>::Escape()
+    {
+      unsigned int steps = 1 + Random::Uniform<unsigned int>(0, static_cast<unsigned int>((1.0 + cycle_length) / 2.0));
+      for (unsigned int s = 0; s < steps; s++)
+      {
+        Move mv;
+        this->ne.RandomMove(*this->p_current_state, mv);
+        this->current_move = EvaluatedMove<Move, CostStructure>(mv, this->ne.DeltaCostFunctionComponents(*this->p_current_state, mv, this->weights));
+        this->evaluations++;
+        MakeMove();
+        auto it = visits.find(fingerprint);
+        if (it == visits.end())
+          AddVisit();
+        else
+        {
+          it->second.last_iteration = this->iteration;
+          it->second.repetitions++;
+        }
+        TabuSearch<Input, State, Move, CostStructure>::CompleteMove();
+        this->UpdateBestState();
+      }
+    }
+
+    /**
+     When the visited states exceed @c max_visited_states, keeps only the
+     most recently visited half of them, so that the forgetting takes
+     constant amortized time.
+     */
+    template <class Input, class State, class Move, class CostStructure>
+    void ReactiveTabuSearch<Input, State, Move, CostStructure>::AddVisit()
+    {
+      visits[fingerprint] = Visit{this->iteration, 1};
+      if (visits.size() <= max_visited_states)
+        return;
+      std::vector<unsigned long int> last_iterations;
+      last_iterations.reserve(visits.size());
+      for (const auto &v : visits)
+        last_iterations.push_back(v.second.last_iteration);
+      auto cut = last_iterations.begin() + (visits.size() - max_visited_states / 2);
+      std::nth_element(last_iterations.begin(), cut, last_iterations.end());
+      const unsigned long int oldest_kept = *cut; // the states visited at the same iteration are kept together
+      for (auto it = visits.begin(); it != visits.end();)
+        if (it->second.last_iteration < oldest_kept)
+          it = visits.erase(it);
+        else
+          ++it;
+    }
+
+    /**
+     Create a string containing the status of the runner
+     */
+    template <class Input, class State, class Move, class CostStructure>
+    std::string ReactiveTabuSearch<Input, State, Move, CostStructure>::StatusString() const
+    {
+      std::stringstream status;
+      status << "T = " << tenure << ", cycle = " << cycle_length << ", visited = " << visits.size() << ", " << TabuSearch<Input, State, Move, CostStructure>::StatusString();
+      return status.str();
+    }
+  } // namespace Core
+} // namespace EasyLocal
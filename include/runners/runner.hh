@@ -5,11 +5,13 @@
 #include <chrono>
 #include <condition_variable>
 #include <atomic>
+#include <memory>
 #include <typeinfo>
 
 #include "helpers/statemanager.hh"
 #include "helpers/neighborhoodexplorer.hh"
 #include "utils/interruptible.hh"
+#include "utils/cancellation.hh"
 #include "utils/parameter.hh"
 #include "helpers/coststructure.hh"
 
@@ -116,7 +118,8 @@ public:
   /** List of all runners that have been instantiated so far. For autoloading. */
   static std::vector<Runner<Input, State, CostStructure> *> runners;
 
-  virtual std::shared_ptr<State> GetCurrentBestState() const;
+  /** Returns a snapshot of the best state found so far, without blocking the search (or nullptr if the runner has never run). The snapshot is immutable and shared among the readers. A call asks the search to publish a new snapshot at the end of its current iteration, if the best state has changed, therefore the snapshot can lag behind the best state by the iterations elapsed since the previous call, and the best state is copied at most once per call however often it improves. */
+  virtual std::shared_ptr<const State> GetCurrentBestState() const;
 
 protected:
   /** Constructor.
@@ -166,6 +169,9 @@ protected:
   /** Actions to be performed after a move has been done. Redefinition intended. */
   virtual void CompleteMove(){};
 
+  /** Actions to be performed whenever the current state is replaced or modified (e.g., to refresh information cached about it). Redefinition intended. */
+  virtual void CurrentStateChanged(){};
+
   /** Implements Interruptible. */
   virtual std::function<CostStructure(State &)> MakeFunction()
   {
@@ -186,7 +192,14 @@ protected:
       /** Best state found so far. */
       p_best_state;
 
-  mutable std::mutex best_state_mutex;
+  /** Snapshot of the best state for the readers, accessed by means of std::atomic_load and std::atomic_store. */
+  std::shared_ptr<const State> best_state_snapshot;
+
+  /** Whether a reader has consumed the snapshot since it has been published. */
+  mutable std::atomic<bool> snapshot_requested;
+
+  /** Index of the iteration where the best state in the snapshot has been found. */
+  unsigned long int snapshot_iteration;
 
   /** Cost of the current state. */
   CostStructure current_state_cost;
@@ -217,6 +230,12 @@ private:
   /** Actions that must be done at the start of the search, and which cannot be redefined by subclasses. */
   void InitializeRun(State &);
 
+  /** Publishes a copy of the best state as the snapshot for the readers. */
+  void PublishBestState();
+
+  /** Brings @c p_best_state up to date, in case its update has been deferred (see @ref MoveRunner). Redefinition intended. */
+  virtual void MaterializeBestState() {}
+
   /** Actions that must be done at the end of the search. */
   CostStructure TerminateRun(State &);
 };
@@ -231,7 +250,7 @@ std::vector<Runner<Input, State, CostStructure> *> Runner<Input, State, CostStru
 template <class Input, class State, class CostStructure>
 Runner<Input, State, CostStructure>::Runner(const Input &in, StateManager<Input, State, CostStructure> &sm, std::string name)
     : // Parameters
-  CommandLineParameters::Parametrized(name, typeid(this).name()), name(name), no_acceptable_move_found(false), in(in), sm(sm), weights(0)
+  CommandLineParameters::Parametrized(name, typeid(this).name()), name(name), no_acceptable_move_found(false), in(in), sm(sm), snapshot_requested(false), snapshot_iteration(0), weights(0)
 {
   // Add to the list of all runners
   runners.push_back(this);
@@ -249,6 +268,9 @@ template <class Input, class State, class CostStructure>
 CostStructure Runner<Input, State, CostStructure>::Go(State &s)
 {
   InitializeRun(s);
+  // the timeout also stops the exploration of the neighborhood in progress
+  const CancellationToken token(this->TimeoutExpired());
+  CancellationToken::Scope cancellation(token);
   while (!MaxEvaluationsExpired() && !StopCriterion() && !LowerBoundReached() && !this->TimeoutExpired())
   {
     PrepareIteration();
@@ -268,6 +290,9 @@ CostStructure Runner<Input, State, CostStructure>::Go(State &s)
       break;
     }
     CompleteIteration();
+    // the best state is copied for the readers only when they ask for it (UpdateBestState sets iteration_of_best on improvements)
+    if (snapshot_requested.load(std::memory_order_relaxed) && iteration_of_best != snapshot_iteration)
+      PublishBestState();
   }
 
   return TerminateRun(s);
@@ -294,19 +319,34 @@ void Runner<Input, State, CostStructure>::CompleteIteration()
 template <class Input, class State, class CostStructure>
 void Runner<Input, State, CostStructure>::InitializeRun(State &s)
 {
+  MaterializeBestState(); // completes a run interrupted by an exception, if any
   iteration = 0;
   iteration_of_best = 0;
   evaluations = 0;
   p_best_state = std::make_shared<State>(s);    // creates the best state object by copying the content of s
   p_current_state = std::make_shared<State>(s); // creates the current state object by copying the content of s
   best_state_cost = current_state_cost = sm.CostFunctionComponents(s);
+  PublishBestState();
+  CurrentStateChanged();
   InitializeRun();
 }
 
+template <class Input, class State, class CostStructure>
+void Runner<Input, State, CostStructure>::PublishBestState()
+{
+  MaterializeBestState();
+  std::atomic_store(&best_state_snapshot, std::shared_ptr<const State>(std::make_shared<State>(*p_best_state)));
+  snapshot_iteration = iteration_of_best;
+  snapshot_requested.store(false, std::memory_order_relaxed);
+}
+
 template <class Input, class State, class CostStructure>
 CostStructure Runner<Input, State, CostStructure>::TerminateRun(State &s)
 {
+  MaterializeBestState();
   s = *p_best_state;
+  if (iteration_of_best != snapshot_iteration)
+    PublishBestState();
   TerminateRun();
   return best_state_cost;
 }
@@ -338,10 +378,11 @@ void Runner<Input, State, CostStructure>::Print(std::ostream &os) const
 }
 
 template <class Input, class State, class CostStructure>
-std::shared_ptr<State> Runner<Input, State, CostStructure>::GetCurrentBestState() const
+std::shared_ptr<const State> Runner<Input, State, CostStructure>::GetCurrentBestState() const
 {
-  std::lock_guard<std::mutex> lock(best_state_mutex);
-  return std::make_shared<State>(*p_best_state); // make a state copy
+  std::shared_ptr<const State> snapshot = std::atomic_load(&best_state_snapshot);
+  snapshot_requested.store(true, std::memory_order_relaxed);
+  return snapshot;
 }
 } // namespace Core
 } // namespace EasyLocal
@@ -44,10 +44,7 @@ namespace EasyLocal
       size_t sampled = 0;
       CostStructure aspiration = this->best_state_cost - this->current_state_cost;
       EvaluatedMove<Move, CostStructure> em = this->ne.RandomBest(*this->p_current_state, samples, sampled, [this, aspiration](const Move &mv, const CostStructure &move_cost) {
-        for (auto li : *(this->tabu_list))
-          if ((move_cost >= aspiration) && this->Inverse(li.move, mv))
-            return false;
-        return true;
+        return !(move_cost >= aspiration && this->IsTabu(mv));
       },
                                                                   this->weights);
       this->current_move = em;
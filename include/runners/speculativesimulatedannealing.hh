@@ -0,0 +1,267 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "runners/simulatedannealing.hh"
+#include "utils/cancellation.hh"
+#include "utils/parallel.hh"
+
+namespace EasyLocal
+{
+
+  namespace Core
+  {
+
+    /** The Speculative Simulated Annealing runner follows the Markov chain
+     of the @ref SimulatedAnnealing runner, but it evaluates the sampled
+     moves in parallel, ahead of their turn.
+
+     The moves (along with the random numbers deciding their acceptance)
+     are drawn in batches, which are evaluated in parallel against the
+     current state, and then they are scanned in sample order, exactly as
+     the serial runner would do, up to the first accepted one. The runner
+     speculates that the moves are independent of the ones accepted before
+     them: when a move is accepted, the evaluations of the following moves
+     of the batch are kept if they are independent of it, and only the
+     dependent ones are evaluated again, in parallel, on the new state. A
+     move is independent of the accepted one if its cost is not changed by
+     it, according to the function given to the constructor or, by
+     default, to @ref NeighborhoodExplorer::MoveInvalidated (whose default
+     implementation makes every move dependent).
+     @note The moves are drawn before the accepted moves preceding them
+     are performed, therefore the chain is the serial one only if @c
+     RandomMove draws the moves independently of the state (e.g., the
+     pairs of positions to be swapped), and if the moves do not store
+     data of the state changed by the accepted moves (the moves which
+     are not feasible anymore are dropped). The sampled moves and the
+     evaluations are counted as in the serial runner, so that the cooling
+     schedule and the stop conditions are the same.
+     @ingroup Runners
+     */
+    template <class Input, class State, class Move, class CostStructure = DefaultCostStructure<int>>
+    class SpeculativeSimulatedAnnealing : public SimulatedAnnealing<Input, State, Move, CostStructure>
+    {
+    public:
+      /** States whether the cost of the move @c mv is not changed by the application of the move @c performed. */
+      typedef std::function<bool(const Move &mv, const Move &performed)> IndependenceFunction;
+
+      using SimulatedAnnealing<Input, State, Move, CostStructure>::SimulatedAnnealing;
+
+      SpeculativeSimulatedAnnealing(const Input &in,
+                                    StateManager<Input, State, CostStructure> &sm,
+                                    NeighborhoodExplorer<Input, State, Move, CostStructure> &ne,
+                                    std::string name,
+                                    IndependenceFunction Independent);
+
+      std::string StatusString() const;
+
+    protected:
+      void InitializeParameters();
+      void InitializeRun();
+      void SelectMove();
+      void CompleteMove();
+      /** Draws a new batch of moves on the current state and evaluates them. */
+      void DrawBatch();
+      /** Evaluates the given moves on the current state, in parallel. */
+      void EvaluateMoves(const Move *moves, size_t n, CostStructure *costs);
+      /** Returns whether the cost of the move @c mv is not changed by the accepted move. */
+      bool IndependentOfCurrentMove(const Move &mv) const;
+
+      /** The moves drawn, in sample order, along with their costs and the random numbers deciding their acceptance (reused across the batches) */
+      std::vector<Move> batch_moves;
+      std::vector<CostStructure> batch_costs;
+      std::vector<double> batch_r;
+      /** The moves from @c next on have not been scanned yet */
+      size_t next;
+      /** The moves of the batch to be evaluated again after an accepted move, along with their positions */
+      std::vector<Move> dependent_moves;
+      std::vector<CostStructure> dependent_costs;
+      std::vector<size_t> dependent_positions;
+      /** The evaluations actually performed (including the ones repeated) */
+      unsigned long int speculative_evaluations;
+
+      IndependenceFunction Independent;
+
+      // parameters
+      Parameter<unsigned int> batch_size;
+    };
+
+    /*************************************************************************
+     * Implementation
+     *************************************************************************/
+
+    /**
+     Constructs a speculative simulated annealing runner whose moves are
+     independent according to a given function.
+
+     @param Independent the function stating whether the cost of a move is
+     not changed by another one
+     */
+    template <class Input, class State, class Move, class CostStructure>
+    SpeculativeSimulatedAnnealing<Input, State, Move, CostStructure>::SpeculativeSimulatedAnnealing(const Input &in,
+                                                                                                    StateManager<Input, State, CostStructure> &sm,
+                                                                                                    NeighborhoodExplorer<Input, State, Move, CostStructure> &ne,
+                                                                                                    std::string name,
+                                                                                                    IndependenceFunction Independent)
+        : SimulatedAnnealing<Input, State, Move, CostStructure>(in, sm, ne, name), Independent(Independent)
+    {
+    }
+
+    template <class Input, class State, class Move, class CostStructure>
+    void SpeculativeSimulatedAnnealing<Input, State, Move, CostStructure>::InitializeParameters()
+    {
+      SimulatedAnnealing<Input, State, Move, CostStructure>::InitializeParameters();
+      batch_size("batch_size", "Number of moves evaluated in parallel ahead of their turn", this->parameters);
+      batch_size = static_cast<unsigned int>(32 * Parallel::MaxConcurrency());
+    }
+
+    /**
+     Initializes the run by invoking the companion superclass method, and
+     dropping the moves drawn in the previous run.
+     */
+    template <class Input, class State, class Move, class CostStructure>
+    void SpeculativeSimulatedAnnealing<Input, State, Move, CostStructure>::InitializeRun()
+    {
+      if (batch_size == 0)
+        throw IncorrectParameterValue(batch_size, "should be greater than zero");
+      SimulatedAnnealing<Input, State, Move, CostStructure>::InitializeRun();
+      this->ne.ResolveComponentSlots(); // the moves are evaluated concurrently
+      batch_moves.clear();
+      next = 0;
+      speculative_evaluations = 0;
+    }
+
+    /**
+     Scans the moves in sample order up to the first accepted one, drawing and
+     evaluating them in batches.
+     */
+    template <class Input, class State, class Move, class CostStructure>
+    void SpeculativeSimulatedAnnealing<Input, State, Move, CostStructure>::SelectMove()
+    {
+      const size_t remaining = this->neighbors_sampled < this->max_neighbors_sampled ? this->max_neighbors_sampled - this->neighbors_sampled : 1;
+      const CancellationToken token = CancellationToken::Current();
+      size_t sampled = 0;
+      this->current_move = EvaluatedMove<Move, CostStructure>();
+      while (sampled < remaining && !token.IsCancelled())
+      {
+        if (next == batch_moves.size())
+          DrawBatch();
+        while (next < batch_moves.size() && sampled < remaining)
+        {
+          const size_t k = next++;
+          sampled++;
+          // the same acceptance criterion of AbstractSimulatedAnnealing::SampleMove
+          if (batch_costs[k] <= 0 || batch_costs[k] < -this->temperature * std::log(batch_r[k]))
+          {
+            this->current_move = EvaluatedMove<Move, CostStructure>(batch_moves[k], batch_costs[k]);
+            break;
+          }
+        }
+        if (this->current_move.is_valid)
+          break;
+      }
+      this->neighbors_sampled += sampled;
+      this->evaluations += sampled;
+    }
+
+    template <class Input, class State, class Move, class CostStructure>
+    void SpeculativeSimulatedAnnealing<Input, State, Move, CostStructure>::DrawBatch()
+    {
+      const size_t n = batch_size;
+      batch_moves.resize(n);
+      batch_costs.resize(n);
+      batch_r.resize(n);
+      for (size_t k = 0; k < n; k++)
+      {
+        this->ne.RandomMove(*this->p_current_state, batch_moves[k]);
+        batch_r[k] = std::max(Random::Uniform<double>(0.0, 1.0), std::numeric_limits<double>::epsilon());
+      }
+      next = 0;
+      EvaluateMoves(batch_moves.data(), n, batch_costs.data());
+    }
+
+    template <class Input, class State, class Move, class CostStructure>
+    void SpeculativeSimulatedAnnealing<Input, State, Move, CostStructure>::EvaluateMoves(const Move *moves, size_t n, CostStructure *costs)
+    {
+      if (n == 0)
+        return;
+      const size_t threads = Parallel::MaxConcurrency();
+      const size_t grain = std::max<size_t>((n + threads - 1) / threads, 8); // smaller chunks do not pay off their dispatch
+      if (grain >= n) // a single chunk is evaluated without dispatching it
+        this->ne.BatchDeltaCostFunctionComponents(*this->p_current_state, moves, n, costs, this->weights);
+      else
+      {
+        const CancellationToken token = CancellationToken::Current();
+        Parallel::Context context;
+        Parallel::For(0, n, grain, [this, &token, moves, costs](size_t first, size_t last) {
+          CancellationToken::Scope cancellation(token);
+          this->ne.BatchDeltaCostFunctionComponents(*this->p_current_state, moves + first, last - first, costs + first, this->weights);
+        },
+                      context);
+      }
+      speculative_evaluations += n;
+    }
+
+    template <class Input, class State, class Move, class CostStructure>
+    bool SpeculativeSimulatedAnnealing<Input, State, Move, CostStructure>::IndependentOfCurrentMove(const Move &mv) const
+    {
+      if (Independent)
+        return Independent(mv, this->current_move.move);
+      return !this->ne.MoveInvalidated(*this->p_current_state, mv, this->current_move.move);
+    }
+
+    /**
+     Keeps the evaluations of the moves drawn ahead which are independent
+     of the accepted move, and evaluates the dependent ones again on the new
+     state.
+     */
+    template <class Input, class State, class Move, class CostStructure>
+    void SpeculativeSimulatedAnnealing<Input, State, Move, CostStructure>::CompleteMove()
+    {
+      SimulatedAnnealing<Input, State, Move, CostStructure>::CompleteMove();
+      dependent_moves.clear();
+      dependent_positions.clear();
+      size_t kept = next;
+      for (size_t i = next; i < batch_moves.size(); i++)
+      {
+        if (!this->ne.FeasibleMove(*this->p_current_state, batch_moves[i]))
+          continue; // dropped
+        if (kept != i)
+        {
+          batch_moves[kept] = std::move(batch_moves[i]);
+          batch_costs[kept] = std::move(batch_costs[i]);
+          batch_r[kept] = batch_r[i];
+        }
+        if (!IndependentOfCurrentMove(batch_moves[kept]))
+        {
+          dependent_moves.push_back(batch_moves[kept]);
+          dependent_positions.push_back(kept);
+        }
+        kept++;
+      }
+      batch_moves.resize(kept);
+      batch_costs.resize(kept);
+      batch_r.resize(kept);
+      dependent_costs.resize(dependent_moves.size());
+      EvaluateMoves(dependent_moves.data(), dependent_moves.size(), dependent_costs.data());
+      for (size_t k = 0; k < dependent_positions.size(); k++)
+        std::swap(batch_costs[dependent_positions[k]], dependent_costs[k]);
+    }
+
+    /**
+     Create a string containing the status of the runner
+     */
+    template <class Input, class State, class Move, class CostStructure>
+    std::string SpeculativeSimulatedAnnealing<Input, State, Move, CostStructure>::StatusString() const
+    {
+      std::stringstream status;
+      status << "T = " << this->temperature << ", evaluations = " << this->evaluations << " (" << speculative_evaluations << " performed)";
+      return status.str();
+    }
+  } // namespace Core
+} // namespace EasyLocal
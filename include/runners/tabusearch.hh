@@ -1,8 +1,12 @@
 #pragma once
 
+#include <algorithm>
 #include <stdexcept>
+#include <string>
 #include <list>
 #include <queue>
+#include <unordered_map>
+#include <vector>
 
 #include "runners/moverunner.hh"
 #include "helpers/statemanager.hh"
@@ -41,6 +45,101 @@ namespace EasyLocal
       container_type &operator*() { return this->c; }
     };
     
+    /** A tabu memory indexed by move attributes (e.g., the value an item had before being moved), which records for each attribute the iteration until which it is tabu, so that checking or making an attribute tabu takes constant time, whatever the number of tabu attributes.
+     The attributes are either integers in a given range, kept in a flat array, or arbitrary integers (e.g., hashes of the attributes), kept in a hash table which is purged of the expired attributes as it grows.
+     */
+    class TabuAttributeMemory
+    {
+    public:
+      /** Constructs the memory.
+       @param attribute_count the number of attributes, in the range [0, attribute_count), or 0 if the attributes are arbitrary integers
+       */
+      TabuAttributeMemory(size_t attribute_count = 0) : expiry(attribute_count, 0), purge_size(purge_threshold) {}
+      
+      /** Returns whether an attribute is tabu at the given iteration. */
+      bool IsTabu(size_t attribute, unsigned long int iteration) const
+      {
+        if (expiry.empty())
+        {
+          auto it = hashed_expiry.find(attribute);
+          return it != hashed_expiry.end() && it->second > iteration;
+        }
+        if (attribute >= expiry.size())
+          throw std::out_of_range("Tabu attribute " + std::to_string(attribute) + " out of range");
+        return expiry[attribute] > iteration;
+      }
+      
+      /** Makes an attribute tabu.
+       @param attribute the attribute
+       @param tenure the last iteration when the attribute is tabu (if it is already tabu until a later iteration, it stays so)
+       @param iteration the current iteration
+       */
+      void MakeTabu(size_t attribute, unsigned long int tenure, unsigned long int iteration)
+      {
+        if (expiry.empty())
+        {
+          unsigned long int &e = hashed_expiry[attribute];
+          e = std::max(e, tenure + 1); // a shorter tenure does not shorten the tabu status of the attribute
+          if (hashed_expiry.size() >= purge_size)
+            Purge(iteration);
+          return;
+        }
+        if (attribute >= expiry.size())
+          throw std::out_of_range("Tabu attribute " + std::to_string(attribute) + " out of range");
+        expiry[attribute] = std::max(expiry[attribute], tenure + 1);
+      }
+      
+      /** Returns the number of attributes which are tabu at the given iteration. */
+      size_t Size(unsigned long int iteration) const
+      {
+        size_t count = 0;
+        for (unsigned long int e : expiry)
+          count += e > iteration;
+        for (const auto &p : hashed_expiry)
+          count += p.second > iteration;
+        return count;
+      }
+      
+      /** Prints the attributes which are tabu at the given iteration, along with their tenures. */
+      void Print(std::ostream &os, unsigned long int iteration) const
+      {
+        size_t i = 0;
+        for (size_t a = 0; a < expiry.size(); a++)
+          if (expiry[a] > iteration)
+            os << (i++ > 0 ? ", " : "") << a << "(" << expiry[a] - 1 << ")";
+        for (const auto &p : hashed_expiry)
+          if (p.second > iteration)
+            os << (i++ > 0 ? ", " : "") << p.first << "(" << p.second - 1 << ")";
+      }
+      
+      void Clear()
+      {
+        std::fill(expiry.begin(), expiry.end(), 0);
+        hashed_expiry.clear();
+        purge_size = purge_threshold;
+      }
+      
+    protected:
+      /** Removes the expired attributes from the hash table, and sets the size at which it is purged again to twice the number of the remaining ones, so that the purges take constant amortized time. */
+      void Purge(unsigned long int iteration)
+      {
+        for (auto it = hashed_expiry.begin(); it != hashed_expiry.end();)
+          if (it->second <= iteration)
+            it = hashed_expiry.erase(it);
+          else
+            ++it;
+        purge_size = std::max(size_t(purge_threshold), 2 * hashed_expiry.size()); // by value, since the constant is not defined out of class
+      }
+      
+      /** The minimum size of the hash table for it to be purged */
+      static const size_t purge_threshold = 1024;
+      
+      /** The iteration after the last one when each attribute is tabu (0 if it has never been tabu) */
+      std::vector<unsigned long int> expiry;
+      std::unordered_map<size_t, unsigned long int> hashed_expiry;
+      size_t purge_size;
+    };
+    
     /** The Tabu Search runner explores a subset of the current
      neighborhood. Among the elements in it, the one that gives the
      minimum value of the cost function becomes the new current
@@ -53,6 +152,14 @@ namespace EasyLocal
      determines the forbidden moves. This list stores the most recently
      accepted moves, and the inverses of the moves in the list are
      forbidden.
+     
+     Alternatively, the tabu status is based on move attributes: the
+     attributes removed from the state by the accepted moves (e.g., the
+     pairs item/old value) become tabu, and the moves adding a tabu
+     attribute to the state are forbidden. Unlike the list, whose size
+     grows with the tenure and which is scanned for each evaluated move,
+     the attributes are kept in a @ref TabuAttributeMemory, therefore
+     checking a move costs the same for every tenure.
      @ingroup Runners
      */
     template <class Input, class State, class Move, class CostStructure = DefaultCostStructure<int>>
@@ -61,11 +168,29 @@ namespace EasyLocal
     public:
       typedef std::function<bool(const Move &lm, const Move &mv)> InverseFunction;
       
+      /** Appends the attributes of a move to a vector. */
+      typedef std::function<void(const Move &mv, std::vector<size_t> &attributes)> AttributeFunction;
+      
       TabuSearch(const Input &in,
                  StateManager<Input, State, CostStructure> &sm,
                  NeighborhoodExplorer<Input, State, Move, CostStructure> &ne,
                  std::string name,
                  InverseFunction Inverse = SameMoveAsInverse);
+      
+      TabuSearch(const Input &in,
+                 StateManager<Input, State, CostStructure> &sm,
+                 NeighborhoodExplorer<Input, State, Move, CostStructure> &ne,
+                 std::string name,
+                 AttributeFunction AddedAttributes,
+                 AttributeFunction RemovedAttributes,
+                 size_t attribute_count = 0);
+      
+      TabuSearch(const Input &in,
+                 StateManager<Input, State, CostStructure> &sm,
+                 NeighborhoodExplorer<Input, State, Move, CostStructure> &ne,
+                 std::string name,
+                 AttributeFunction Attributes,
+                 size_t attribute_count = 0);
       std::string StatusString() const;
       
       virtual void Print(std::ostream &os = std::cout) const;
@@ -77,13 +202,21 @@ namespace EasyLocal
       void SelectMove();
       void CompleteMove();
       void InitializeParameters();
+      /** Returns whether a move is prohibited by the tabu list or by the tabu attributes (regardless of the aspiration criterion). */
+      bool IsTabu(const Move &mv) const;
+      /** Returns the number of iterations for which the current move stays tabu.
+       @remarks MayRedef: by default it is drawn uniformly between the minimum and the maximum tenure
+       */
+      virtual unsigned int Tenure();
       InverseFunction Inverse;
+      AttributeFunction AddedAttributes, RemovedAttributes;
       
       static InverseFunction SameMoveAsInverse;
       
       typedef QueueAdapter<std::priority_queue<TabuListItem<Move>, std::vector<TabuListItem<Move>>, typename TabuListItem<Move>::Comparator>> PriorityQueue;
       
       PriorityQueue tabu_list;
+      TabuAttributeMemory tabu_attributes;
       // parameters
       Parameter<unsigned long int> max_idle_iterations;
       Parameter<unsigned int> min_tenure, max_tenure;
@@ -113,6 +246,42 @@ namespace EasyLocal
     {
     }
     
+    /**
+     Constructs a tabu search runner whose tabu status is based on move attributes.
+     
+     @param AddedAttributes the function giving the attributes a move adds to the state, a move is prohibited if one of them is tabu
+     @param RemovedAttributes the function giving the attributes a move removes from the state, which become tabu once it is performed
+     @param attribute_count the number of attributes, in the range [0, attribute_count), or 0 if they are arbitrary integers (e.g., hashes)
+     */
+    template <class Input, class State, class Move, class CostStructure>
+    TabuSearch<Input, State, Move, CostStructure>::TabuSearch(const Input &in,
+                                                              StateManager<Input, State, CostStructure> &sm,
+                                                              NeighborhoodExplorer<Input, State, Move, CostStructure> &ne,
+                                                              std::string name,
+                                                              AttributeFunction AddedAttributes,
+                                                              AttributeFunction RemovedAttributes,
+                                                              size_t attribute_count)
+    : MoveRunner<Input, State, Move, CostStructure>(in, sm, ne, name), AddedAttributes(AddedAttributes), RemovedAttributes(RemovedAttributes), tabu_attributes(attribute_count)
+    {
+    }
+    
+    /**
+     Constructs a tabu search runner whose tabu status is based on move attributes, where a move is prohibited if it shares an attribute with the recently performed ones (e.g., the items they moved).
+     
+     @param Attributes the function giving the attributes of a move
+     @param attribute_count the number of attributes, in the range [0, attribute_count), or 0 if they are arbitrary integers (e.g., hashes)
+     */
+    template <class Input, class State, class Move, class CostStructure>
+    TabuSearch<Input, State, Move, CostStructure>::TabuSearch(const Input &in,
+                                                              StateManager<Input, State, CostStructure> &sm,
+                                                              NeighborhoodExplorer<Input, State, Move, CostStructure> &ne,
+                                                              std::string name,
+                                                              AttributeFunction Attributes,
+                                                              size_t attribute_count)
+    : TabuSearch(in, sm, ne, name, Attributes, Attributes, attribute_count)
+    {
+    }
+    
     template <class Input, class State, class Move, class CostStructure>
     void TabuSearch<Input, State, Move, CostStructure>::InitializeParameters()
     {
@@ -127,6 +296,7 @@ namespace EasyLocal
     {
       Runner<Input, State, CostStructure>::Print(os);
       os << "{";
+      tabu_attributes.Print(os, this->iteration);
       size_t i = 0;
       for (typename PriorityQueue::container_type::const_iterator it = (*tabu_list).begin(); it != (*tabu_list).end(); ++it)
       {
@@ -147,6 +317,7 @@ namespace EasyLocal
     {
       MoveRunner<Input, State, Move, CostStructure>::InitializeRun();
       (*tabu_list).clear();
+      tabu_attributes.Clear();
     }
     
     /**
@@ -159,16 +330,38 @@ namespace EasyLocal
       CostStructure aspiration = this->best_state_cost - this->current_state_cost;
       size_t explored;
       EvaluatedMove<Move, CostStructure> em = this->ne.SelectBest(*this->p_current_state, explored, [this, aspiration](const Move &mv, const CostStructure &move_cost) {
-        for (auto li : *(this->tabu_list))
-          if ((move_cost >= aspiration) && this->Inverse(li.move, mv))
-            return false;
-        return true;
+        return !(move_cost >= aspiration && this->IsTabu(mv));
       },
                                                                   this->weights);
       this->current_move = em;
       this->evaluations += explored;
     }
     
+    template <class Input, class State, class Move, class CostStructure>
+    bool TabuSearch<Input, State, Move, CostStructure>::IsTabu(const Move &mv) const
+    {
+      if (AddedAttributes)
+      {
+        static thread_local std::vector<size_t> attributes; // the move evaluations may run in parallel
+        attributes.clear();
+        AddedAttributes(mv, attributes);
+        for (size_t a : attributes)
+          if (tabu_attributes.IsTabu(a, this->iteration))
+            return true;
+        return false;
+      }
+      for (const auto &li : *tabu_list)
+        if (Inverse(li.move, mv))
+          return true;
+      return false;
+    }
+    
+    template <class Input, class State, class Move, class CostStructure>
+    unsigned int TabuSearch<Input, State, Move, CostStructure>::Tenure()
+    {
+      return Random::Uniform<unsigned int>(min_tenure, max_tenure);
+    }
+    
     template <class Input, class State, class Move, class CostStructure>
     bool TabuSearch<Input, State, Move, CostStructure>::MaxIdleIterationExpired() const
     {
@@ -192,11 +385,20 @@ namespace EasyLocal
     template <class Input, class State, class Move, class CostStructure>
     void TabuSearch<Input, State, Move, CostStructure>::CompleteMove()
     {
+      unsigned long int tenure = this->iteration + Tenure();
+      if (AddedAttributes)
+      {
+        std::vector<size_t> attributes;
+        RemovedAttributes(this->current_move.move, attributes);
+        for (size_t a : attributes) // like the moves in the list, up to the end of the iteration after the tenure
+          tabu_attributes.MakeTabu(a, tenure + 1, this->iteration);
+        return;
+      }
       // remove no more tabu moves
       while (!tabu_list.empty() && tabu_list.top().tenure < this->iteration)
         tabu_list.pop();
       // insert current move
-      tabu_list.emplace(this->current_move.move, this->iteration + Random::Uniform<unsigned int>(min_tenure, max_tenure));
+      tabu_list.emplace(this->current_move.move, tenure);
     }
     
     /**
@@ -206,6 +408,13 @@ namespace EasyLocal
     std::string TabuSearch<Input, State, Move, CostStructure>::StatusString() const
     {
       std::stringstream status;
+      if (AddedAttributes)
+      {
+        status << "TA = #" << tabu_attributes.Size(this->iteration) << "[";
+        tabu_attributes.Print(status, this->iteration);
+        status << "]";
+        return status.str();
+      }
       status << "TL = #" << tabu_list.size() << "[";
       size_t i = 0;
       for (auto li : (*tabu_list))
@@ -41,7 +41,7 @@ namespace EasyLocal
       virtual std::shared_ptr<Output> GetCurrentSolution() const;
       
     protected:
-      virtual std::shared_ptr<State> GetCurrentState() const = 0;
+      virtual std::shared_ptr<const State> GetCurrentState() const = 0;
       
       virtual ~AbstractLocalSearch()
       {
@@ -195,11 +195,13 @@ namespace EasyLocal
     template <class Input, class Output, class State, class CostStructure>
     std::shared_ptr<Output> AbstractLocalSearch<Input, Output, State, CostStructure>::GetCurrentSolution() const
     {
-      std::shared_ptr<State> current_state;
+      std::shared_ptr<const State> current_state;
       if (!is_running)
         current_state = this->p_best_state;
       else
         current_state = GetCurrentState();
+      if (!current_state)
+        return nullptr; // the runner has not published its best state yet
       std::shared_ptr<Output> out = std::make_shared<Output>(this->in);
       om.OutputState(*current_state, *out);
       return out;
@@ -39,7 +39,7 @@ protected:
   void InitializeSolve() throw(ParameterNotSet, IncorrectParameterValue);
   void Go();
   void AtTimeoutExpired();
-  virtual std::shared_ptr<State> GetCurrentState() const;
+  virtual std::shared_ptr<const State> GetCurrentState() const;
 
   std::vector<RunnerType *> p_runners; /**< pointers to the managed runner. */
   unsigned int current_runner;
@@ -192,7 +192,7 @@ void MultiStartSearch<Input, Output, State, CostStructure>::AtTimeoutExpired()
 }
 
 template <class Input, class Output, class State, class CostStructure>
-void MultiStartSearch<Input, Output, State, CostStructure>::GetCurrentState() const
+std::shared_ptr<const State> MultiStartSearch<Input, Output, State, CostStructure>::GetCurrentState() const
 {
   return p_runners[current_runner]->GetCurrentBestState();
 }
@@ -30,7 +30,7 @@ namespace EasyLocal
       Runner<Input, State, CostStructure>* GetRunner() const { return p_runner; }
       void Print(std::ostream &os = std::cout) const;
       void ReadParameters(std::istream &is = std::cin, std::ostream &os = std::cout);
-      virtual std::shared_ptr<State> GetCurrentState() const;
+      virtual std::shared_ptr<const State> GetCurrentState() const;
       
     protected:
       void Go();
@@ -101,7 +101,7 @@ namespace EasyLocal
     }
     
     template <class Input, class Output, class State, class CostStructure>
-    std::shared_ptr<State> SimpleLocalSearch<Input, Output, State, CostStructure>::GetCurrentState() const
+    std::shared_ptr<const State> SimpleLocalSearch<Input, Output, State, CostStructure>::GetCurrentState() const
     {
       return this->p_runner->GetCurrentBestState();
     }
@@ -62,7 +62,7 @@ public:
        */
   Solver(const Input &in, std::string name);
 
-  /** Get current solution (meant to be asyncrhonous) */
+  /** Get current solution (meant to be asyncrhonous), or nullptr if no solution is available yet */
   virtual std::shared_ptr<Output> GetCurrentSolution() const = 0;
 
 protected:
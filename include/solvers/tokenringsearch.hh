@@ -39,7 +39,7 @@ protected:
   void Go();
   void AtTimeoutExpired();
   void ResetTimeout();
-  virtual std::shared_ptr<State> GetCurrentState() const;
+  virtual std::shared_ptr<const State> GetCurrentState() const;
 
   std::vector<RunnerType *> p_runners; /**< pointers to the managed runner. */
   unsigned int current_runner;
@@ -192,7 +192,7 @@ void TokenRingSearch<Input, Output, State, CostStructure>::ResetTimeout()
 }
 
 template <class Input, class Output, class State, class CostStructure>
-std::shared_ptr<State> TokenRingSearch<Input, Output, State, CostStructure>::GetCurrentState() const
+std::shared_ptr<const State> TokenRingSearch<Input, Output, State, CostStructure>::GetCurrentState() const
 {
   return p_runners[current_runner]->GetCurrentBestState();
 }
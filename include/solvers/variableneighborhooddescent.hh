@@ -28,7 +28,7 @@ public:
 protected:
   void Go();
   // Kicker<Input, State, CostStructure>* p_kicker; /**< A pointer to the managed kicker. */
-  virtual std::shared_ptr<State> GetCurrentState() const;
+  virtual std::shared_ptr<const State> GetCurrentState() const;
 
   unsigned int max_k;
 };
@@ -6,4 +6,6 @@
 #include "utils/types.hh"
 #include "utils/interruptible.hh"
 #include "utils/parameter.hh"
+#include "utils/pagedvector.hh"
+#include "utils/weightedsampler.hh"
 
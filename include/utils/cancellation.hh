@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+namespace EasyLocal
+{
+
+namespace Core
+{
+
+/** A token asking a long computation (e.g., the exploration of a large neighborhood) to stop early and to return the best result found so far, because a flag has been raised (e.g., the timeout flag of an @ref Interruptible) or because a deadline has passed.
+     The token of the calling thread is set by means of @ref Scope, so that it reaches the computations without changing their interfaces, and the computations poll the token returned by @ref Current every some steps. A default-constructed token is never cancelled.
+     */
+class CancellationToken
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  /** Constructs a token which is never cancelled. */
+  CancellationToken() : flag(nullptr), deadline(Clock::time_point::max()) {}
+
+  /** Constructs a token which is cancelled once the flag is raised.
+       @param flag the flag, which must outlive the token
+       */
+  explicit CancellationToken(const std::atomic<bool> &flag) : flag(&flag), deadline(Clock::time_point::max()) {}
+
+  /** Constructs a token which is cancelled once the deadline has passed.
+       @param deadline the deadline
+       */
+  explicit CancellationToken(Clock::time_point deadline) : flag(nullptr), deadline(deadline) {}
+
+  /** Returns whether the computation should stop. */
+  bool IsCancelled() const
+  {
+    if (flag != nullptr && flag->load(std::memory_order_relaxed))
+      return true;
+    return deadline != Clock::time_point::max() && Clock::now() >= deadline;
+  }
+
+  /** Returns the token of the calling thread (a copy, which can be handed over to other threads). */
+  static CancellationToken Current()
+  {
+    const CancellationToken *token = Redirection();
+    return token != nullptr ? *token : CancellationToken();
+  }
+
+  /** Sets the token of the calling thread for the lifetime of the object, replacing the enclosing one (if any). */
+  class Scope
+  {
+  public:
+    Scope(const CancellationToken &token) : previous(Redirection())
+    {
+      Redirection() = &token;
+    }
+    ~Scope()
+    {
+      Redirection() = previous;
+    }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    const CancellationToken *previous;
+  };
+
+protected:
+  static const CancellationToken *&Redirection()
+  {
+    static thread_local const CancellationToken *token = nullptr;
+    return token;
+  }
+
+  const std::atomic<bool> *flag;
+  Clock::time_point deadline;
+};
+} // namespace Core
+} // namespace EasyLocal
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace EasyLocal
+{
+
+namespace Core
+{
+
+/** A pool of persistent threads running long-lived tasks (e.g., whole runs of a runner or of a solver), each one on a thread of its own. Threads are created only when all the existing ones are busy, and they wait for further tasks after completing one, so that, in the steady state, submitting a task costs a queue push instead of the creation of a thread. At most @c max_idle threads wait for tasks, and each of them exits after waiting for @c idle_timeout, so that the threads created by a burst of tasks are reclaimed.
+     @note Unlike @ref ThreadPool, the tasks are never queued behind running ones, since they could wait for each other.
+     */
+class Executor
+{
+public:
+  typedef std::function<void()> Task;
+
+  /** Returns the executor shared by the framework. */
+  static Executor &Instance()
+  {
+    static Executor executor;
+    return executor;
+  }
+
+  /** Constructs the executor.
+       @param max_idle the maximum number of threads waiting for tasks
+       @param idle_timeout the time after which a thread waiting for tasks exits
+       */
+  Executor(size_t max_idle = std::max(1u, std::thread::hardware_concurrency()), std::chrono::milliseconds idle_timeout = std::chrono::seconds(10))
+      : state(std::make_shared<State>(max_idle, idle_timeout)) {}
+
+  Executor(const Executor &) = delete;
+  Executor &operator=(const Executor &) = delete;
+
+  /** Cancels the running tasks and waits (for a bounded time) for them to terminate. The threads of the tasks which do not terminate in time are left running, as detached threads, until the end of the process, therefore a task which never terminates does not prevent it from exiting. */
+  ~Executor()
+  {
+    const std::chrono::seconds grace(1);
+    std::unique_lock<std::mutex> lock(state->mx);
+    state->stopping = true;
+    for (const Task &cancel : state->running)
+      if (cancel)
+        cancel();
+    state->cv.notify_all();
+    state->exited.wait_for(lock, grace, [this]() { return state->threads == 0; });
+  }
+
+  /** Submits a task, which is started right away by an idle thread or by a new one.
+       @param task the task
+       @param cancel a function asking the task to terminate early (e.g., by interrupting a run), which is invoked if the executor is destroyed while the task is running
+       */
+  void Submit(Task task, Task cancel = Task())
+  {
+    std::lock_guard<std::mutex> lock(state->mx);
+    state->tasks.push_back(Job{std::move(task), std::move(cancel)});
+    if (state->tasks.size() <= state->idle)
+      state->cv.notify_one();
+    else
+    {
+      std::thread(&Executor::Loop, state).detach();
+      state->threads++;
+    }
+  }
+
+  /** Returns the number of threads currently alive. */
+  size_t Threads() const
+  {
+    std::lock_guard<std::mutex> lock(state->mx);
+    return state->threads;
+  }
+
+protected:
+  struct Job
+  {
+    Task task, cancel;
+  };
+
+  /** The state shared with the threads, which are detached and therefore might outlive the executor. */
+  struct State
+  {
+    State(size_t max_idle, std::chrono::milliseconds idle_timeout) : idle(0), threads(0), stopping(false), max_idle(max_idle), idle_timeout(idle_timeout) {}
+    std::mutex mx;
+    std::condition_variable cv, exited;
+    std::deque<Job> tasks;
+    /** The cancellation functions of the running tasks */
+    std::list<Task> running;
+    size_t idle, threads;
+    bool stopping;
+    const size_t max_idle;
+    const std::chrono::milliseconds idle_timeout;
+  };
+
+  static void Loop(std::shared_ptr<State> state)
+  {
+    std::unique_lock<std::mutex> lock(state->mx);
+    while (true)
+    {
+      state->idle++;
+      state->cv.wait_for(lock, state->idle_timeout, [&state]() { return state->stopping || !state->tasks.empty(); });
+      state->idle--;
+      if (state->stopping || state->tasks.empty()) // or idle for too long
+        break;
+      Job job = std::move(state->tasks.front());
+      state->tasks.pop_front();
+      auto running = state->running.insert(state->running.end(), std::move(job.cancel));
+      lock.unlock();
+      job.task();
+      job.task = nullptr; // releases the resources of the task out of the lock
+      lock.lock();
+      state->running.erase(running);
+      if (state->idle >= state->max_idle) // enough threads are waiting for tasks already
+        break;
+    }
+    state->threads--;
+    state->exited.notify_all();
+  }
+
+  std::shared_ptr<State> state;
+};
+} // namespace Core
+} // namespace EasyLocal
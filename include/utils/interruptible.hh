@@ -6,6 +6,12 @@
 #include <atomic>
 #include <thread>
 #include <condition_variable>
+#include <memory>
+#include <tuple>
+#include <utility>
+
+#include "utils/executor.hh"
+#include "utils/timerservice.hh"
 
 namespace EasyLocal
 {
@@ -31,7 +37,8 @@ void sleep_for(std::chrono::duration<Rep, Period> sleep_duration)
 }
 #endif
 
-/** A mixin class to add timeouts to anything. */
+/** A mixin class to add timeouts to anything.
+     The timeouts are handled by the shared @ref TimerService, and the asynchronous runs by the shared @ref Executor, so that no thread is created for each run. */
 template <typename Rtype, typename... Args>
 class Interruptible
 {
@@ -39,54 +46,33 @@ public:
   /** Constructor, sets timeout_expired to false to avoid problems when classes are called without threads. */
   Interruptible() : timeout_expired(false) {}
 
-  /** Runs this interruptible synchronously for a specified number of milliseconds.
+  /** Runs this interruptible synchronously for a specified number of milliseconds. The function is run on the calling thread, and the timeout is signalled by the thread of the @ref TimerService.
        @param timeout a duration in milliseconds
        @param args the list of arguments to pass (possibly empty)
        */
   Rtype SyncRun(std::chrono::milliseconds timeout, Args... args)
   {
     timeout_expired = false;
-    std::future<Rtype> result = std::async(std::launch::async, this->MakeFunction(), std::ref(args)...);
-
-    // If timeout is greater than zero
-    if (timeout.count() != 0)
-    {
-      if (result.wait_for(timeout) != std::future_status::ready)
-      {
-        timeout_expired = true;
-        AtTimeoutExpired();
-      }
-    }
-    else
-    {
-      result.wait();
-    }
-    return result.get();
+    TimeoutTimer timer(*this, timeout);
+    return this->MakeFunction()(args...);
   }
 
-  /** Runs this interruptible asynchronously for a specified number of milliseconds.
+  /** Runs this interruptible asynchronously for a specified number of milliseconds. The function is run on a thread of the @ref Executor, which interrupts it if the process exits while it is running.
        @param timeout a duration in milliseconds
        @param args the list of arguments to pass (possibly empty)
        */
   std::shared_future<Rtype> AsyncRun(std::chrono::milliseconds timeout, Args... args)
   {
     timeout_expired = false;
-    std::shared_future<Rtype> result = std::async(std::launch::async, this->MakeFunction(), std::ref(args)...);
-
-    // If timeout is greater than zero, launch stopper thread
-    if (timeout.count() != 0)
-    {
-      std::thread t([this, timeout, result]() {
-        sleep_for(timeout);
-        // If the function has not returned a value already
-        if (result.wait_for(std::chrono::milliseconds::zero()) == std::future_status::ready)
-        {
-          timeout_expired = true;
-          AtTimeoutExpired();
-        }
-      });
-      t.detach();
-    }
+    std::function<Rtype(Args &...)> f = this->MakeFunction();
+    std::tuple<Args...> arguments(args...);
+    std::unique_ptr<TimeoutTimer> timer(new TimeoutTimer(*this, timeout));
+    auto run = std::make_shared<std::packaged_task<Rtype()>>([f, arguments, timer = std::move(timer)]() mutable -> Rtype {
+      std::unique_ptr<TimeoutTimer> t(std::move(timer)); // cancelled before the result is made ready
+      return Apply(f, arguments, std::index_sequence_for<Args...>());
+    });
+    std::shared_future<Rtype> result = run->get_future();
+    Executor::Instance().Submit([run]() { (*run)(); }, [this]() { Interrupt(); }); // interrupted if the process exits while running
     return result;
   }
 
@@ -105,7 +91,7 @@ protected:
   /** Checks if timeout has expired. */
   inline const std::atomic<bool> &TimeoutExpired() { return timeout_expired; }
 
-  /** Produces a function object to be launched in a separate thread. */
+  /** Produces the function object run by @ref SyncRun and @ref AsyncRun. */
   inline virtual std::function<Rtype(Args &...)> MakeFunction()
   {
     // Default behavior
@@ -118,6 +104,36 @@ protected:
   virtual void AtTimeoutExpired() {}
 
 private:
+  /** Signals the expiration of a timeout (if not zero) by means of the @ref TimerService, until it is destroyed. */
+  class TimeoutTimer
+  {
+  public:
+    TimeoutTimer(Interruptible &interruptible, std::chrono::milliseconds timeout) : id(0)
+    {
+      if (timeout.count() != 0)
+        id = TimerService::Instance().Schedule(timeout, [&interruptible]() {
+          interruptible.timeout_expired = true;
+          interruptible.AtTimeoutExpired();
+        });
+    }
+    ~TimeoutTimer()
+    {
+      if (id != 0)
+        TimerService::Instance().Cancel(id);
+    }
+    TimeoutTimer(const TimeoutTimer &) = delete;
+    TimeoutTimer &operator=(const TimeoutTimer &) = delete;
+
+  private:
+    TimerService::TimerId id;
+  };
+
+  template <size_t... I>
+  static Rtype Apply(std::function<Rtype(Args &...)> &f, std::tuple<Args...> &arguments, std::index_sequence<I...>)
+  {
+    return f(std::get<I>(arguments)...);
+  }
+
   /** Atomic flags. */
   std::atomic<bool> timeout_expired;
 };
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace EasyLocal
+{
+
+namespace Core
+{
+
+/** A vector whose elements are stored in pages of fixed size, which are shared, copy-on-write, among the copies of the vector. Copying a vector only copies the pointers to its pages, and a page is duplicated the first time it is modified in one of the copies, so that a @c State built on it can be copied (e.g., for the best state, the snapshots for the readers, the steps of a kick or a checkpoint) in time and memory proportional to the number of its pages, and the copies only take the memory of the pages which differ.
+     Elements are read by means of the const methods, which never duplicate a page, and they are modified by means of @ref Set or of the non-const subscript operator, which duplicate the page if it is shared (therefore a non-const vector should be read through a const reference).
+     @note As for std::vector, different copies can be used by different threads at the same time, but each copy by one thread at a time.
+     @ingroup Utils
+     */
+template <class T, size_t PageSize = (sizeof(T) < 4096 ? 4096 / sizeof(T) : 1)>
+class PagedVector
+{
+  static_assert(PageSize > 0, "The pages must contain at least one element");
+
+protected:
+  struct Page
+  {
+    std::array<T, PageSize> elements;
+  };
+
+public:
+  typedef T value_type;
+  typedef size_t size_type;
+
+  /** A read-only iterator over the elements. */
+  class const_iterator
+  {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const T *pointer;
+    typedef const T &reference;
+
+    const_iterator(const PagedVector &v, size_t i) : v(&v), i(i) {}
+    const T &operator*() const { return (*v)[i]; }
+    const T *operator->() const { return &(*v)[i]; }
+    const_iterator &operator++()
+    {
+      i++;
+      return *this;
+    }
+    const_iterator operator++(int)
+    {
+      const_iterator it = *this;
+      i++;
+      return it;
+    }
+    bool operator==(const const_iterator &it) const { return i == it.i && v == it.v; }
+    bool operator!=(const const_iterator &it) const { return !(*this == it); }
+
+  protected:
+    const PagedVector *v;
+    size_t i;
+  };
+
+  PagedVector() : count(0) {}
+
+  /** Constructs a vector of @c n copies of @c value. */
+  explicit PagedVector(size_t n, const T &value = T()) : count(0)
+  {
+    resize(n, value);
+  }
+
+  /** Returns the number of elements. */
+  size_t size() const
+  {
+    return count;
+  }
+
+  bool empty() const
+  {
+    return count == 0;
+  }
+
+  /** Returns the number of elements in a page. */
+  static constexpr size_t page_size()
+  {
+    return PageSize;
+  }
+
+  const T &operator[](size_t i) const
+  {
+    return pages[i / PageSize]->elements[i % PageSize];
+  }
+
+  /** Returns a modifiable reference to an element, duplicating its page if it is shared. */
+  T &operator[](size_t i)
+  {
+    return Writable(i / PageSize).elements[i % PageSize];
+  }
+
+  const T &at(size_t i) const
+  {
+    if (i >= count)
+      throw std::out_of_range("PagedVector index out of range");
+    return (*this)[i];
+  }
+
+  /** Sets an element, duplicating its page if it is shared. */
+  void Set(size_t i, const T &value)
+  {
+    Writable(i / PageSize).elements[i % PageSize] = value;
+  }
+
+  const T &front() const
+  {
+    return (*this)[0];
+  }
+
+  const T &back() const
+  {
+    return (*this)[count - 1];
+  }
+
+  const_iterator begin() const
+  {
+    return const_iterator(*this, 0);
+  }
+
+  const_iterator end() const
+  {
+    return const_iterator(*this, count);
+  }
+
+  void push_back(const T &value)
+  {
+    if (count % PageSize == 0)
+      pages.push_back(std::make_shared<Page>());
+    Set(count++, value);
+  }
+
+  void pop_back()
+  {
+    if (--count % PageSize == 0)
+      pages.pop_back();
+  }
+
+  /** Resizes the vector, filling the new positions with @c value. */
+  void resize(size_t n, const T &value = T())
+  {
+    if (n < count)
+    {
+      pages.resize((n + PageSize - 1) / PageSize);
+      count = n;
+      return;
+    }
+    pages.reserve((n + PageSize - 1) / PageSize);
+    while (count < n && count % PageSize != 0)
+      Set(count++, value);
+    if (count < n)
+    {
+      // the new full pages are all the same, and they are duplicated only once modified
+      std::shared_ptr<Page> filled = std::make_shared<Page>();
+      filled->elements.fill(value);
+      while (n - count >= PageSize)
+      {
+        pages.push_back(filled);
+        count += PageSize;
+      }
+      if (count < n)
+        pages.push_back(std::make_shared<Page>(*filled));
+      count = n;
+    }
+  }
+
+  void clear()
+  {
+    pages.clear();
+    count = 0;
+  }
+
+  void swap(PagedVector &v)
+  {
+    pages.swap(v.pages);
+    std::swap(count, v.count);
+  }
+
+  /** Returns the number of pages. */
+  size_t Pages() const
+  {
+    return pages.size();
+  }
+
+  /** Returns the number of pages shared with another vector (e.g., a copy of this one). */
+  size_t SharedPages(const PagedVector &v) const
+  {
+    size_t shared = 0;
+    for (size_t p = 0; p < pages.size() && p < v.pages.size(); p++)
+      shared += (pages[p] == v.pages[p]);
+    return shared;
+  }
+
+  bool operator==(const PagedVector &v) const
+  {
+    if (count != v.count)
+      return false;
+    for (size_t p = 0; p < pages.size(); p++)
+      if (pages[p] != v.pages[p]) // shared pages are not compared element-wise
+        for (size_t i = p * PageSize; i < count && i < (p + 1) * PageSize; i++)
+          if (!((*this)[i] == v[i]))
+            return false;
+    return true;
+  }
+
+  bool operator!=(const PagedVector &v) const
+  {
+    return !(*this == v);
+  }
+
+protected:
+  /** Returns a page which is not shared with other vectors, duplicating it if needed. */
+  Page &Writable(size_t p)
+  {
+    if (pages[p].use_count() > 1)
+      pages[p] = std::make_shared<Page>(*pages[p]);
+    else
+      std::atomic_thread_fence(std::memory_order_acquire); // the former sharers (if any) are done with the page
+    return *pages[p];
+  }
+
+  std::vector<std::shared_ptr<Page>> pages;
+  size_t count;
+};
+} // namespace Core
+} // namespace EasyLocal
@@ -0,0 +1,344 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(TBB_AVAILABLE)
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/global_control.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_pipeline.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/spin_mutex.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
+#else
+#include "utils/threadpool.hh"
+#endif
+
+namespace EasyLocal
+{
+
+namespace Core
+{
+
+/** Utility static class providing the parallel algorithms used by the parallel helpers (see @ref ParallelNeighborhoodExplorer and @ref ParallelKicker), independently of the backend executing them. The backend is TBB when TBB_AVAILABLE is defined, otherwise it is the built-in work-stealing @ref ThreadPool, which only requires std::thread.
+     The algorithms work on ranges of indices, which are split in chunks of at most @c grain consecutive indices, and they can be cancelled by means of a @ref Context: once the context is cancelled, the chunks not yet started are skipped. An exception thrown by a body cancels the remaining chunks and it is rethrown to the caller.
+     */
+class Parallel
+{
+public:
+  /** Returns the name of the backend. */
+  static const char *Backend()
+  {
+#if defined(TBB_AVAILABLE)
+    return "TBB";
+#else
+    return "threads";
+#endif
+  }
+
+  /** Returns the maximum number of threads running the algorithms. */
+  static size_t MaxConcurrency()
+  {
+#if defined(TBB_AVAILABLE)
+    return static_cast<size_t>(tbb::this_task_arena::max_concurrency());
+#else
+    return ThreadPool::Instance().Concurrency();
+#endif
+  }
+
+  /** Limits the number of threads running the algorithms for the lifetime of the object.
+       @note With the built-in backend, the pool is resized, therefore the object must not be created or destroyed while algorithms are running.
+       */
+  class ScopedConcurrency
+  {
+  public:
+    ScopedConcurrency(size_t concurrency)
+#if defined(TBB_AVAILABLE)
+        : control(tbb::global_control::max_allowed_parallelism, concurrency)
+    {
+    }
+#else
+        : previous(ThreadPool::Instance().Concurrency())
+    {
+      ThreadPool::Instance().Resize(concurrency);
+    }
+    ~ScopedConcurrency()
+    {
+      ThreadPool::Instance().Resize(previous);
+    }
+#endif
+    ScopedConcurrency(const ScopedConcurrency &) = delete;
+    ScopedConcurrency &operator=(const ScopedConcurrency &) = delete;
+
+  protected:
+#if defined(TBB_AVAILABLE)
+    tbb::global_control control;
+#else
+    size_t previous;
+#endif
+  };
+
+  /** The cancellation state shared by the chunks of an algorithm. */
+  class Context
+  {
+    friend class Parallel;
+
+  public:
+#if defined(TBB_AVAILABLE)
+    /** Cancels the chunks not yet started. */
+    void Cancel()
+    {
+      context.cancel_group_execution();
+    }
+
+    /** Returns whether the context has been cancelled. */
+    bool IsCancelled() const
+    {
+      return context.is_group_execution_cancelled();
+    }
+
+  protected:
+    mutable tbb::task_group_context context;
+#else
+    Context() : cancelled(false) {}
+
+    /** Cancels the chunks not yet started. */
+    void Cancel()
+    {
+      cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    /** Returns whether the context has been cancelled. */
+    bool IsCancelled() const
+    {
+      return cancelled.load(std::memory_order_relaxed);
+    }
+
+  protected:
+    std::atomic<bool> cancelled;
+#endif
+  };
+
+#if defined(TBB_AVAILABLE)
+  typedef tbb::spin_mutex SpinMutex;
+#else
+  /** A mutex for short critical sections, which busy-waits instead of blocking. */
+  class SpinMutex
+  {
+  public:
+    SpinMutex() : locked(false) {}
+    void lock()
+    {
+      while (locked.exchange(true, std::memory_order_acquire))
+        while (locked.load(std::memory_order_relaxed))
+          std::this_thread::yield();
+    }
+    void unlock()
+    {
+      locked.store(false, std::memory_order_release);
+    }
+
+  protected:
+    std::atomic<bool> locked;
+  };
+#endif
+
+  /** An object with a separate instance for each thread, created lazily at the first access of the thread by means of a factory. */
+  template <class T>
+  class ThreadSpecific
+  {
+  public:
+    ThreadSpecific() : ThreadSpecific([]() { return T(); }) {}
+
+    template <class Factory>
+    explicit ThreadSpecific(Factory factory)
+#if defined(TBB_AVAILABLE)
+        : instances(factory)
+    {
+    }
+#else
+        : factory(factory), instances(ThreadPool::Instance().Concurrency())
+    {
+    }
+#endif
+
+    /** Returns the instance of the calling thread. */
+    T &Local()
+    {
+#if defined(TBB_AVAILABLE)
+      return instances.local();
+#else
+      // the workers of the pool have a slot each, the other threads are looked up
+      size_t index = ThreadPool::Instance().ThreadIndex();
+      if (index + 1 < instances.size())
+      {
+        if (!instances[index])
+          instances[index].reset(new T(factory()));
+        return *instances[index];
+      }
+      std::lock_guard<std::mutex> lock(mx_others);
+      for (std::pair<std::thread::id, T> &instance : others)
+        if (instance.first == std::this_thread::get_id())
+          return instance.second;
+      others.emplace_back(std::this_thread::get_id(), factory());
+      return others.back().second;
+#endif
+    }
+
+    /** Applies a function to each of the instances created so far. */
+    template <class F>
+    void CombineEach(const F &f) const
+    {
+#if defined(TBB_AVAILABLE)
+      instances.combine_each(f);
+#else
+      for (const std::unique_ptr<T> &instance : instances)
+        if (instance)
+          f(*instance);
+      for (const std::pair<std::thread::id, T> &instance : others)
+        f(instance.second);
+#endif
+    }
+
+  protected:
+#if defined(TBB_AVAILABLE)
+    mutable tbb::enumerable_thread_specific<T> instances;
+#else
+    std::function<T()> factory;
+    std::vector<std::unique_ptr<T>> instances;
+    std::deque<std::pair<std::thread::id, T>> others;
+    std::mutex mx_others;
+#endif
+  };
+
+  /** Runs a body over the range [first, last), split in chunks which are processed in parallel.
+       @param first the beginning of the range
+       @param last the end of the range
+       @param grain the maximum size of a chunk
+       @param body a function void(size_t chunk_first, size_t chunk_last)
+       @param context the cancellation context
+       */
+  template <class Body>
+  static void For(size_t first, size_t last, size_t grain, const Body &body, Context &context)
+  {
+    if (first >= last)
+      return;
+#if defined(TBB_AVAILABLE)
+    tbb::parallel_for(tbb::blocked_range<size_t>(first, last, std::max<size_t>(grain, 1)), [&body](const tbb::blocked_range<size_t> &r) { body(r.begin(), r.end()); }, tbb::simple_partitioner(), context.context); // the auto partitioner would exceed the grain
+#else
+    ThreadPool::TaskGroup group;
+    group.Run([&group, first, last, grain, &body, &context]() { Split(group, first, last, std::max<size_t>(grain, 1), body, context); });
+    group.Wait();
+#endif
+  }
+
+  /** Reduces the range [first, last), split in chunks which are processed in parallel.
+       @param first the beginning of the range
+       @param last the end of the range
+       @param grain the maximum size of a chunk
+       @param identity the identity of the reduction
+       @param body a function T(size_t chunk_first, size_t chunk_last, T init), which accumulates a chunk to init
+       @param join a function T(const T &a, const T &b), which combines two partial results
+       @param context the cancellation context
+       */
+  template <class T, class Body, class Join>
+  static T Reduce(size_t first, size_t last, size_t grain, const T &identity, const Body &body, const Join &join, Context &context)
+  {
+    if (first >= last)
+      return identity;
+#if defined(TBB_AVAILABLE)
+    return tbb::parallel_reduce(tbb::blocked_range<size_t>(first, last, std::max<size_t>(grain, 1)), identity, [&body](const tbb::blocked_range<size_t> &r, T init) -> T { return body(r.begin(), r.end(), init); }, join, tbb::simple_partitioner(), context.context);
+#else
+    grain = std::max<size_t>(grain, 1);
+    const size_t chunks = (last - first + grain - 1) / grain;
+    std::vector<T> partials(chunks, identity);
+    For(0, chunks, 1, [&partials, &body, first, last, grain](size_t chunk_first, size_t chunk_last) {
+      for (size_t c = chunk_first; c < chunk_last; c++)
+        partials[c] = body(first + c * grain, std::min(last, first + (c + 1) * grain), partials[c]);
+    },
+        context);
+    T result = identity;
+    for (const T &partial : partials)
+      result = join(result, partial);
+    return result;
+#endif
+  }
+
+  /** Processes in parallel a stream of items produced serially, with a bounded number of items in flight.
+       @param tokens the maximum number of items in flight
+       @param produce a function bool(Item &item), called serially, which returns false once the stream is over
+       @param consume a function void(Item &item)
+       @param context the cancellation context
+       */
+  template <class Item, class Produce, class Consume>
+  static void Pipeline(size_t tokens, const Produce &produce, const Consume &consume, Context &context)
+  {
+#if defined(TBB_AVAILABLE)
+    tbb::parallel_pipeline(tokens,
+                           tbb::make_filter<void, Item>(tbb::filter_mode::serial_in_order, [&produce](tbb::flow_control &fc) {
+                             Item item;
+                             if (!produce(item))
+                               fc.stop();
+                             return item;
+                           }) &
+                               tbb::make_filter<Item, void>(tbb::filter_mode::parallel, [&consume](Item item) { consume(item); }),
+                           context.context);
+#else
+    ThreadPool::TaskGroup group;
+    std::atomic<size_t> in_flight(0);
+    while (!context.IsCancelled() && !group.Failed())
+    {
+      group.Pool().HelpWhile([&in_flight, tokens]() { return in_flight.load() >= tokens; });
+      Item item;
+      if (!produce(item))
+        break;
+      in_flight++;
+      group.Run([&consume, &context, &in_flight, item = std::move(item)]() mutable {
+        try
+        {
+          if (!context.IsCancelled())
+            consume(item);
+        }
+        catch (...)
+        {
+          in_flight--;
+          throw;
+        }
+        in_flight--;
+      });
+    }
+    group.Wait();
+#endif
+  }
+
+#if !defined(TBB_AVAILABLE)
+protected:
+  /** Splits a range in halves, spawning the upper ones, down to chunks of at most @c grain indices. */
+  template <class Body>
+  static void Split(ThreadPool::TaskGroup &group, size_t first, size_t last, size_t grain, const Body &body, Context &context)
+  {
+    while (last - first > grain)
+    {
+      if (context.IsCancelled() || group.Failed())
+        return;
+      size_t middle = first + (last - first) / 2;
+      group.Run([&group, middle, last, grain, &body, &context]() { Split(group, middle, last, grain, body, context); });
+      last = middle;
+    }
+    if (!context.IsCancelled() && !group.Failed())
+      body(first, last);
+  }
+#endif
+};
+} // namespace Core
+} // namespace EasyLocal
@@ -2,23 +2,98 @@
 
 #include <random>
 #include <iostream>
+#include <atomic>
+#include <cstdint>
+#include <limits>
 
 namespace EasyLocal
 {
-  
+
   namespace Core
   {
-    
-    // TODO: Create a singleton for the Random class
-    
+
+    /** The xoshiro256** generator by Blackman and Vigna, a fast 64-bit engine with a small state, which provides non-overlapping streams by means of @ref jump. */
+    class Xoshiro256StarStar
+    {
+    public:
+      typedef uint64_t result_type;
+
+      Xoshiro256StarStar(result_type seed = 5489u)
+      {
+        this->seed(seed);
+      }
+
+      /** Sets the state expanding the seed by means of splitmix64. */
+      void seed(result_type seed)
+      {
+        for (uint64_t &x : s)
+        {
+          uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+          z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+          z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+          x = z ^ (z >> 31);
+        }
+      }
+
+      static constexpr result_type min() { return 0; }
+      static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+      result_type operator()()
+      {
+        const uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+      }
+
+      /** Advances the state by 2^128 steps, i.e., to the beginning of the next non-overlapping stream. */
+      void jump()
+      {
+        static const uint64_t JUMP[] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+        uint64_t t[4] = {0, 0, 0, 0};
+        for (uint64_t j : JUMP)
+          for (int b = 0; b < 64; b++)
+          {
+            if (j & (uint64_t(1) << b))
+              for (int i = 0; i < 4; i++)
+                t[i] ^= s[i];
+            (*this)();
+          }
+        for (int i = 0; i < 4; i++)
+          s[i] = t[i];
+      }
+
+    private:
+      static uint64_t rotl(const uint64_t x, int k)
+      {
+        return (x << k) | (x >> (64 - k));
+      }
+
+      uint64_t s[4];
+    };
+
     /** Utility static class to generate pseudo-random values according to distributions.
      In order to make experiments repeatable, each solver must include:
-     
+
      Random::Seed(value);
+
+     Each thread draws from its own generator, therefore the class can be used concurrently. The generators are different streams derived from the master seed: the thread which sets the seed (or, if none is set, the first one using the class) gets stream 0, which is the sequence of a single generator seeded with the master seed, the other threads get the following streams in order of first use. Parallel code which has to be reproducible should not depend on that order, and it should rather draw from explicitly numbered streams by means of @ref Stream and @ref ScopedStream.
+     @note The engine is std::mt19937, unless EASYLOCAL_XOSHIRO_ENGINE is defined, in which case it is the faster @ref Xoshiro256StarStar.
      */
     class Random
     {
     public:
+#if defined(EASYLOCAL_XOSHIRO_ENGINE)
+      typedef Xoshiro256StarStar Engine;
+#else
+      typedef std::mt19937 Engine;
+#endif
+
       /** Generates an uniform random integer in [a, b].
        @param a lower bound
        @param b upper bound
@@ -26,10 +101,10 @@ namespace EasyLocal
       template <typename T, typename std::enable_if<std::is_integral<T>::value>::type* = nullptr>
       static T Uniform(T a, T b)
       {
-        std::uniform_int_distribution<T> d(a, b);
-        return d(GetInstance().g);
+        static thread_local std::uniform_int_distribution<T> d;
+        return d(GetGenerator(), typename std::uniform_int_distribution<T>::param_type(a, b));
       }
-      
+
       /** Generates an uniform random float in [a, b].
        @param a lower bound
        @param b upper bound
@@ -37,45 +112,148 @@ namespace EasyLocal
       template <typename T, typename std::enable_if<std::is_floating_point<T>::value>::type* = nullptr>
       static T Uniform(T a, T b)
       {
-        std::uniform_real_distribution<T> d(a, b);
-        return d(GetInstance().g);
+        static thread_local std::uniform_real_distribution<T> d;
+        return d(GetGenerator(), typename std::uniform_real_distribution<T>::param_type(a, b));
       }
-      
+
       /** Sets a new seed for the random engine. */
       static unsigned int SetSeed(unsigned int seed)
       {
         Random& r = GetInstance();
-        r.g.seed(seed);
-        return r.seed = seed;
+        r.seed = seed;
+        r.next_stream = 1;
+        // the calling thread gets the first stream (without drawing from next_stream), the others are reseeded at their next use
+        ThreadGenerator &tg = LocalThreadGenerator();
+        SeedStream(tg.g, seed, 0);
+        tg.epoch = ++Epoch();
+        return seed;
       }
-      
+
       static unsigned int GetSeed()
       {
         return GetInstance().seed;
       }
-      
-      
-      static std::mt19937& GetGenerator()
+
+      /** Returns the generator currently used by the calling thread. */
+      static Engine& GetGenerator()
+      {
+        Engine* redirected = Redirection();
+        if (redirected != nullptr)
+          return *redirected;
+        // fast path, on trivially initialized thread-local variables
+        static thread_local Engine* own = nullptr;
+        static thread_local unsigned long own_epoch = 0;
+        if (own_epoch != Epoch().load(std::memory_order_relaxed))
+        {
+          ThreadGenerator &tg = GetThreadGenerator();
+          own = &tg.g;
+          own_epoch = tg.epoch;
+        }
+        return *own;
+      }
+
+      /** Returns a generator for the given stream derived from the master seed. Stream 0 is the sequence of the thread which sets the seed. */
+      static Engine Stream(unsigned long stream)
       {
-        return GetInstance().g;
+        Engine g;
+        SeedStream(g, GetInstance().seed, stream);
+        return g;
       }
-      
+
+      /** Makes the calling thread draw from a given generator for the lifetime of the object, e.g., in order to make the moves generated by a task independent of the thread running it. */
+      class ScopedStream
+      {
+      public:
+        ScopedStream(Engine &g) : previous(Redirection())
+        {
+          Redirection() = &g;
+        }
+        ~ScopedStream()
+        {
+          Redirection() = previous;
+        }
+        ScopedStream(const ScopedStream&) = delete;
+        ScopedStream& operator=(const ScopedStream&) = delete;
+
+      private:
+        Engine* previous;
+      };
+
     private:
+      struct ThreadGenerator
+      {
+        ThreadGenerator() : epoch(0) {}
+        Engine g;
+        unsigned long epoch;
+      };
+
       static Random& GetInstance() {
         static Random instance;
         return instance;
       }
-      
-      Random()
+
+      /** Returns the generator of the calling thread as it is, i.e., without checking its seed. */
+      static ThreadGenerator& LocalThreadGenerator()
+      {
+        static thread_local ThreadGenerator tg;
+        return tg;
+      }
+
+      /** Returns the generator of the calling thread, (re)seeding it if the master seed has changed since its last use. */
+      static ThreadGenerator& GetThreadGenerator()
+      {
+        ThreadGenerator &tg = LocalThreadGenerator();
+        Random& r = GetInstance();
+        unsigned long epoch = Epoch();
+        if (tg.epoch != epoch)
+        {
+          SeedStream(tg.g, r.seed, r.next_stream++);
+          tg.epoch = epoch;
+        }
+        return tg;
+      }
+
+      /** The number of seeds set so far (plus one), used to detect the generators to be reseeded. */
+      static std::atomic<unsigned long>& Epoch()
+      {
+        static std::atomic<unsigned long> epoch(1);
+        return epoch;
+      }
+
+      /** The generator the calling thread has been redirected to by a @ref ScopedStream (if any). */
+      static Engine*& Redirection()
+      {
+        static thread_local Engine* redirected = nullptr;
+        return redirected;
+      }
+
+      static void SeedStream(std::mt19937 &g, unsigned int seed, unsigned long stream)
+      {
+        if (stream == 0)
+          g.seed(seed);
+        else
+        {
+          std::seed_seq seq{static_cast<unsigned long>(seed), stream};
+          g.seed(seq);
+        }
+      }
+
+      static void SeedStream(Xoshiro256StarStar &g, unsigned int seed, unsigned long stream)
+      {
+        g.seed(seed);
+        for (unsigned long i = 0; i < stream; i++)
+          g.jump();
+      }
+
+      Random() : next_stream(0)
       {
         std::random_device dev;
         seed = dev();
-        g.seed(seed);
       }
-      
-      std::mt19937 g;
-      
+
       unsigned int seed;
+
+      std::atomic<unsigned long> next_stream;
     };
   } // namespace Core
 } // namespace EasyLocal
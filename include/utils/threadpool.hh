@@ -0,0 +1,303 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace EasyLocal
+{
+
+namespace Core
+{
+
+/** A pool of worker threads which execute tasks by means of work stealing. Each worker owns a queue of tasks: the tasks spawned by a worker are pushed on its own queue, and they are executed by the worker in LIFO order or stolen by the idle workers in FIFO order, while the tasks spawned by other threads go to a shared queue, which they use in the same way. A thread waiting for a group of tasks (see @ref TaskGroup) does not block, it rather executes pending tasks, therefore tasks can spawn and wait for other tasks.
+     @note The concurrency of the pool includes the thread waiting for the tasks, which takes part in their execution, i.e., a pool of concurrency @e n runs @e n - 1 workers.
+     */
+class ThreadPool
+{
+public:
+  typedef std::function<void()> Task;
+
+  /** A group of tasks which can be waited for. The exception thrown by a task (if any) marks the group as failed, and it is rethrown by @ref Wait. */
+  class TaskGroup
+  {
+  public:
+    TaskGroup(ThreadPool &pool = ThreadPool::Instance()) : pool(pool), pending(0), failed(false) {}
+
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    ~TaskGroup()
+    {
+      pool.HelpWhile([this]() { return pending.load() > 0; });
+    }
+
+    /** Spawns a task in the group. */
+    template <class F>
+    void Run(F f)
+    {
+      pending++;
+      pool.Spawn([this, f]() mutable {
+        {
+          F g(std::move(f)); // destroyed before the group is released
+          try
+          {
+            g();
+          }
+          catch (...)
+          {
+            Fail(std::current_exception());
+          }
+        }
+        pending--;
+      });
+    }
+
+    /** Waits for all the tasks of the group (executing pending tasks meanwhile) and rethrows the first exception thrown by them, if any. */
+    void Wait()
+    {
+      pool.HelpWhile([this]() { return pending.load() > 0; });
+      if (failed)
+      {
+        failed = false;
+        std::rethrow_exception(exception);
+      }
+    }
+
+    /** Returns whether a task of the group has thrown an exception. */
+    bool Failed() const
+    {
+      return failed.load(std::memory_order_relaxed);
+    }
+
+    /** Returns the pool executing the tasks. */
+    ThreadPool &Pool() const
+    {
+      return pool;
+    }
+
+  protected:
+    void Fail(std::exception_ptr e)
+    {
+      std::lock_guard<std::mutex> lock(mx_exception);
+      if (!failed)
+      {
+        exception = e;
+        failed = true;
+      }
+    }
+
+    ThreadPool &pool;
+    std::atomic<size_t> pending;
+    std::atomic<bool> failed;
+    std::exception_ptr exception;
+    std::mutex mx_exception;
+  };
+
+  /** Constructs a pool of the given concurrency.
+       @param concurrency the number of threads executing the tasks, including the waiting one
+       */
+  explicit ThreadPool(size_t concurrency = DefaultConcurrency()) : worker_count(0), queued(0), sleeping(0), stopping(false)
+  {
+    Start(concurrency);
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  ~ThreadPool()
+  {
+    Stop();
+  }
+
+  /** Returns the pool shared by the parallel helpers. */
+  static ThreadPool &Instance()
+  {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  /** Returns the concurrency of a pool constructed without arguments, i.e., the number of hardware threads. */
+  static size_t DefaultConcurrency()
+  {
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  /** Returns the number of threads executing the tasks, including the waiting one. */
+  size_t Concurrency() const
+  {
+    return worker_count + 1;
+  }
+
+  /** Changes the concurrency of the pool, restarting its workers.
+       @note It must not be called while the pool is executing tasks.
+       */
+  void Resize(size_t concurrency)
+  {
+    if (concurrency == Concurrency())
+      return;
+    Stop();
+    Start(concurrency);
+  }
+
+  /** Returns the position of the calling thread among the workers of this pool, or @c Concurrency() - 1 if it is not one of them. */
+  size_t ThreadIndex() const
+  {
+    return CurrentPool() == this ? CurrentIndex() : worker_count;
+  }
+
+  /** Spawns a task, which is pushed on the queue of the calling worker (or on the shared queue if the calling thread is not a worker of this pool). */
+  void Spawn(Task task)
+  {
+    TaskQueue &queue = CurrentPool() == this ? *queues[CurrentIndex()] : shared_queue;
+    {
+      std::lock_guard<std::mutex> lock(queue.mx);
+      queue.tasks.push_back(std::move(task));
+    }
+    queued++;
+    if (sleeping.load() > 0)
+    {
+      std::lock_guard<std::mutex> lock(mx_sleep);
+      cv_sleep.notify_one();
+    }
+  }
+
+  /** Executes pending tasks as long as the condition holds. */
+  template <class Condition>
+  void HelpWhile(const Condition &condition)
+  {
+    while (condition())
+      if (!RunOneTask())
+        std::this_thread::yield();
+  }
+
+protected:
+  /** A queue of tasks, used as a stack by its owner and as a queue by the thieves. */
+  struct TaskQueue
+  {
+    bool PopBack(Task &task)
+    {
+      std::lock_guard<std::mutex> lock(mx);
+      if (tasks.empty())
+        return false;
+      task = std::move(tasks.back());
+      tasks.pop_back();
+      return true;
+    }
+    bool PopFront(Task &task)
+    {
+      std::lock_guard<std::mutex> lock(mx);
+      if (tasks.empty())
+        return false;
+      task = std::move(tasks.front());
+      tasks.pop_front();
+      return true;
+    }
+    std::mutex mx;
+    std::deque<Task> tasks;
+  };
+
+  /** Executes a task from the own queue of the calling thread, from the shared one or stolen from another worker, and returns whether one was found. */
+  bool RunOneTask()
+  {
+    if (queued.load(std::memory_order_relaxed) == 0)
+      return false;
+    Task task;
+    const size_t n = worker_count, self = ThreadIndex();
+    // the own tasks are taken from the back, the ones of the other threads from the front
+    bool found = self < n ? queues[self]->PopBack(task) || shared_queue.PopFront(task) : shared_queue.PopBack(task);
+    for (size_t k = 1; !found && k <= n; k++)
+      found = queues[(self + k) % n]->PopFront(task);
+    if (!found)
+      return false;
+    queued--;
+    task();
+    return true;
+  }
+
+  void WorkerLoop(size_t index)
+  {
+    CurrentPool() = this;
+    CurrentIndex() = index;
+    unsigned int idle_rounds = 0;
+    while (true)
+    {
+      if (RunOneTask())
+      {
+        idle_rounds = 0;
+        continue;
+      }
+      if (++idle_rounds < spin_rounds)
+      {
+        std::this_thread::yield();
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(mx_sleep);
+      sleeping++;
+      cv_sleep.wait(lock, [this]() { return stopping || queued.load() > 0; });
+      sleeping--;
+      if (stopping)
+        return;
+      idle_rounds = 0;
+    }
+  }
+
+  void Start(size_t concurrency)
+  {
+    stopping = false;
+    worker_count = std::max<size_t>(concurrency, 1) - 1; // set before the workers start, which read it
+    queues.clear();
+    for (size_t i = 0; i < worker_count; i++)
+      queues.emplace_back(new TaskQueue());
+    for (size_t i = 0; i < worker_count; i++)
+      workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+  }
+
+  void Stop()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mx_sleep);
+      stopping = true;
+      cv_sleep.notify_all();
+    }
+    for (std::thread &worker : workers)
+      worker.join();
+    workers.clear();
+    worker_count = 0;
+  }
+
+  /** The pool the calling thread is a worker of (if any). */
+  static ThreadPool *&CurrentPool()
+  {
+    static thread_local ThreadPool *pool = nullptr;
+    return pool;
+  }
+
+  /** The position of the calling thread among the workers of its pool. */
+  static size_t &CurrentIndex()
+  {
+    static thread_local size_t index = 0;
+    return index;
+  }
+
+  /** The number of attempts to find a task before an idle worker goes to sleep */
+  static const unsigned int spin_rounds = 64;
+
+  std::vector<std::thread> workers;
+  size_t worker_count;
+  std::vector<std::unique_ptr<TaskQueue>> queues;
+  TaskQueue shared_queue;
+  std::atomic<size_t> queued, sleeping;
+  std::mutex mx_sleep;
+  std::condition_variable cv_sleep;
+  bool stopping;
+};
+} // namespace Core
+} // namespace EasyLocal
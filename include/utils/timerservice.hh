@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace EasyLocal
+{
+
+namespace Core
+{
+
+/** A service which runs callbacks at given deadlines on a single thread, started at the first use. Timers are kept in a hashed timing wheel, i.e., a circular array of slots each one collecting the timers expiring at the same tick modulo the size of the wheel, so that scheduling and cancelling a timer take constant time, and the thread only wakes up at the ticks when some timer expires.
+     @note Callbacks are run one at a time on the thread of the service, therefore they should be short.
+     */
+class TimerService
+{
+public:
+  typedef unsigned long long TimerId;
+
+  typedef std::chrono::steady_clock Clock;
+
+  /** Returns the service shared by the framework. */
+  static TimerService &Instance()
+  {
+    static TimerService service;
+    return service;
+  }
+
+  /** Constructs a timer service.
+       @param tick the resolution of the timers
+       */
+  TimerService(std::chrono::milliseconds tick = std::chrono::milliseconds(1)) : tick(tick), wheel(wheel_size), origin(Clock::now()), current_tick(0), wakeup_tick(std::numeric_limits<unsigned long long>::max()), next_id(1), running(0), stopping(false) {}
+
+  TimerService(const TimerService &) = delete;
+  TimerService &operator=(const TimerService &) = delete;
+
+  ~TimerService()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mx);
+      stopping = true;
+      cv.notify_all();
+    }
+    if (thread.joinable())
+      thread.join();
+  }
+
+  /** Schedules a callback after a delay (rounded up to the next tick).
+       @param delay the delay
+       @param callback the function to call
+       @return the identifier of the timer, to be used for cancelling it
+       */
+  TimerId Schedule(std::chrono::milliseconds delay, std::function<void()> callback)
+  {
+    std::lock_guard<std::mutex> lock(mx);
+    if (!thread.joinable())
+      thread = std::thread(&TimerService::Loop, this);
+    const Clock::duration due = Clock::now() - origin + delay;
+    if (timers.empty())
+      current_tick = std::max(current_tick, CurrentTick()); // no need to go through the ticks elapsed meanwhile
+    unsigned long long expiry = std::max(current_tick + 1, static_cast<unsigned long long>((due + tick - Clock::duration(1)) / tick));
+    std::list<Timer> &slot = wheel[expiry % wheel_size];
+    TimerId id = next_id++;
+    timers[id] = slot.insert(slot.end(), Timer{id, expiry, std::move(callback)});
+    if (expiry < wakeup_tick)
+      cv.notify_all();
+    return id;
+  }
+
+  /** Cancels a timer. If its callback is running, it waits for the callback to complete, so that it is never run after this method has returned.
+       @param id the identifier of the timer
+       @return true if the timer has been cancelled before its expiration
+       */
+  bool Cancel(TimerId id)
+  {
+    std::unique_lock<std::mutex> lock(mx);
+    auto it = timers.find(id);
+    if (it != timers.end())
+    {
+      wheel[it->second->expiry % wheel_size].erase(it->second);
+      timers.erase(it);
+      return true;
+    }
+    for (auto it = firing.begin(); it != firing.end(); ++it)
+      if (it->id == id) // expired, but its callback has not been run yet
+      {
+        firing.erase(it);
+        return true;
+      }
+    if (std::this_thread::get_id() != thread.get_id())
+      cv_done.wait(lock, [this, id]() { return running != id; });
+    return false;
+  }
+
+protected:
+  struct Timer
+  {
+    TimerId id;
+    unsigned long long expiry;
+    std::function<void()> callback;
+  };
+
+  /** The number of ticks elapsed since the construction of the service. */
+  unsigned long long CurrentTick() const
+  {
+    return static_cast<unsigned long long>((Clock::now() - origin) / tick);
+  }
+
+  /** The first tick when a timer expires (the timers must not be empty). */
+  unsigned long long NextExpiry() const
+  {
+    unsigned long long next = std::numeric_limits<unsigned long long>::max();
+    for (unsigned long long t = current_tick + 1; t <= current_tick + wheel_size; t++)
+      for (const Timer &timer : wheel[t % wheel_size])
+      {
+        if (timer.expiry == t)
+          return t; // nothing can expire earlier than the first visited slot
+        next = std::min(next, timer.expiry);
+      }
+    return next;
+  }
+
+  void Loop()
+  {
+    std::unique_lock<std::mutex> lock(mx);
+    while (!stopping)
+    {
+      if (timers.empty())
+      {
+        wakeup_tick = std::numeric_limits<unsigned long long>::max();
+        cv.wait(lock);
+        continue;
+      }
+      wakeup_tick = NextExpiry();
+      if (wakeup_tick > CurrentTick())
+      {
+        cv.wait_until(lock, origin + tick * wakeup_tick);
+        continue;
+      }
+      // collect the expired timers, visiting each slot at most once
+      const unsigned long long now = CurrentTick();
+      for (unsigned long long t = current_tick + 1; t <= now && t <= current_tick + wheel_size; t++)
+      {
+        std::list<Timer> &slot = wheel[t % wheel_size];
+        for (auto it = slot.begin(); it != slot.end();)
+          if (it->expiry <= now)
+          {
+            timers.erase(it->id);
+            firing.splice(firing.end(), slot, it++);
+          }
+          else
+            ++it;
+      }
+      current_tick = now;
+      while (!firing.empty())
+      {
+        Timer timer = std::move(firing.front());
+        firing.pop_front();
+        running = timer.id;
+        lock.unlock();
+        timer.callback();
+        lock.lock();
+        running = 0;
+        cv_done.notify_all();
+      }
+    }
+  }
+
+  /** The number of slots of the wheel */
+  static const size_t wheel_size = 256;
+
+  const std::chrono::milliseconds tick;
+  std::vector<std::list<Timer>> wheel;
+  std::unordered_map<TimerId, std::list<Timer>::iterator> timers;
+  /** The expired timers whose callbacks have still to be run */
+  std::list<Timer> firing;
+  const Clock::time_point origin;
+  unsigned long long current_tick, wakeup_tick;
+  TimerId next_id, running;
+  bool stopping;
+  std::mutex mx;
+  std::condition_variable cv, cv_done;
+  std::thread thread;
+};
+} // namespace Core
+} // namespace EasyLocal
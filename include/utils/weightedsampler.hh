@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace EasyLocal
+{
+
+namespace Core
+{
+
+/** A collection of non-negative weights, indexed from 0 to @c size() - 1, from which an index is drawn with probability proportional to its weight. The weights are kept in a Fenwick tree, so that changing a weight and drawing an index take logarithmic time, and the total weight is maintained along.
+     @note The updates accumulate rounding errors, therefore the weights should be assigned again (see @ref Assign) every some updates.
+     @ingroup Utils
+     */
+class WeightedSampler
+{
+public:
+  WeightedSampler() : total(0.0) {}
+
+  /** Returns the number of weights. */
+  size_t size() const
+  {
+    return weights.size();
+  }
+
+  /** Assigns all the weights at once (in linear time). */
+  void Assign(const std::vector<double> &w)
+  {
+    weights = w;
+    tree.assign(weights.size() + 1, 0.0);
+    total = 0.0;
+    for (size_t i = 0; i < weights.size(); i++)
+    {
+      tree[i + 1] += weights[i];
+      total += weights[i];
+      size_t parent = (i + 1) + ((i + 1) & -(i + 1));
+      if (parent <= weights.size())
+        tree[parent] += tree[i + 1];
+    }
+  }
+
+  /** Returns the weight of an index. */
+  double Weight(size_t i) const
+  {
+    return weights[i];
+  }
+
+  /** Changes the weight of an index. */
+  void Set(size_t i, double w)
+  {
+    const double delta = w - weights[i];
+    weights[i] = w;
+    total += delta;
+    for (size_t k = i + 1; k < tree.size(); k += k & -k)
+      tree[k] += delta;
+  }
+
+  /** Returns the sum of the weights. */
+  double Total() const
+  {
+    return std::max(total, 0.0);
+  }
+
+  /** Returns the index whose range of cumulative weight contains @c u, which is drawn uniformly in [0, @ref Total()) by the caller, i.e., an index with probability proportional to its weight.
+       @throws std::logic_error if all the weights are null
+       */
+  size_t Sample(double u) const
+  {
+    size_t pos = 0, step = 1;
+    while (2 * step <= weights.size())
+      step *= 2;
+    for (; step > 0; step /= 2)
+      if (pos + step <= weights.size() && tree[pos + step] <= u)
+      {
+        pos += step;
+        u -= tree[pos];
+      }
+    // the rounding errors might lead to a null weight (or past the end)
+    for (size_t k = 0; k < weights.size(); k++)
+    {
+      if (pos + k < weights.size() && weights[pos + k] > 0.0)
+        return pos + k;
+      if (k > 0 && k <= pos && weights[pos - k] > 0.0)
+        return pos - k;
+    }
+    throw std::logic_error("No index has a positive weight");
+  }
+
+protected:
+  std::vector<double> weights;
+  /** The Fenwick tree of the weights, indexed from 1 */
+  std::vector<double> tree;
+  double total;
+};
+} // namespace Core
+} // namespace EasyLocal